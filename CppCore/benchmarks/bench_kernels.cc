@@ -0,0 +1,104 @@
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <random>
+#include <string>
+
+#include "xtensor/xtensor.hpp"
+
+#include "xtsci/func/trial/D2/branin.hpp"
+#include "xtsci/func/trial/D2/eggholder.hpp"
+#include "xtsci/func/trial/D2/mullerbrown.hpp"
+
+// Points per second of the packed batch path against a plain loop over the
+// scalar kernels, for f and \nabla f in float and double. Build with
+// -Dwith_xsimd=true to see the SIMD gain, otherwise both columns run the same
+// scalar code.
+
+namespace {
+
+constexpr size_t n_points  = size_t{1} << 16;
+constexpr size_t n_repeats = 7;
+
+// Best of n_repeats, in points per second
+template <class Fn> double throughput(Fn &&fn) {
+  double best = 0;
+  for (size_t rep = 0; rep < n_repeats; ++rep) {
+    const auto start = std::chrono::steady_clock::now();
+    fn();
+    const std::chrono::duration<double> elapsed
+        = std::chrono::steady_clock::now() - start;
+    best = std::max(best, static_cast<double>(n_points) / elapsed.count());
+  }
+  return best;
+}
+
+template <template <typename> class Trial, typename ScalarType>
+void bench(
+    const std::string &name, const std::string &dtype, double lo, double hi,
+    double &checksum) {
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> dist(lo, hi);
+  xt::xtensor<ScalarType, 2> pts
+      = xt::empty<ScalarType>({n_points, size_t{2}});
+  for (auto &val : pts) {
+    val = static_cast<ScalarType>(dist(rng));
+  }
+  Trial<ScalarType> func;
+  using Kernels        = Trial<ScalarType>;
+  const ScalarType *xy = pts.data();
+
+  const double scalar_f = throughput([&] {
+    ScalarType acc = 0;
+    for (size_t idx = 0; idx < n_points; ++idx) {
+      acc += Kernels::value_kernel(xy[2 * idx], xy[2 * idx + 1]);
+    }
+    checksum += acc;
+  });
+  const double batch_f = throughput(
+      [&] { checksum += func.evaluate_batch(pts)(n_points - 1); });
+  const double scalar_g = throughput([&] {
+    ScalarType acc = 0;
+    for (size_t idx = 0; idx < n_points; ++idx) {
+      acc += Kernels::gradient_kernel(xy[2 * idx], xy[2 * idx + 1])[0];
+    }
+    checksum += acc;
+  });
+  const double batch_g = throughput(
+      [&] { checksum += (*func.gradient_batch(pts))(n_points - 1, 0); });
+
+  fmt::print(
+      "{:<12} {:<7} {:<5} {:>12.3e} {:>12.3e} {:>8.2f}x\n", name, dtype, "f",
+      scalar_f, batch_f, batch_f / scalar_f);
+  fmt::print(
+      "{:<12} {:<7} {:<5} {:>12.3e} {:>12.3e} {:>8.2f}x\n", name, dtype,
+      "grad", scalar_g, batch_g, batch_g / scalar_g);
+}
+
+} // namespace
+
+int main() {
+  namespace D2    = xts::func::trial::D2;
+  double checksum = 0;
+#ifdef XTSCI_USE_XSIMD
+  fmt::print("SIMD kernels enabled (xsimd)\n");
+#else
+  fmt::print("SIMD kernels disabled, configure with -Dwith_xsimd=true\n");
+#endif
+  fmt::print(
+      "{:<12} {:<7} {:<5} {:>12} {:>12} {:>9}\n", "function", "dtype", "eval",
+      "scalar pt/s", "batch pt/s", "speedup");
+  bench<D2::MullerBrown, double>("MullerBrown", "double", -1.5, 2.0, checksum);
+  bench<D2::MullerBrown, float>("MullerBrown", "float", -1.5, 2.0, checksum);
+  bench<D2::Branin, double>("Branin", "double", -5.0, 15.0, checksum);
+  bench<D2::Branin, float>("Branin", "float", -5.0, 15.0, checksum);
+  bench<D2::Eggholder, double>("Eggholder", "double", -512, 512, checksum);
+  bench<D2::Eggholder, float>("Eggholder", "float", -512, 512, checksum);
+  // Keeps the timed loops from being optimised away
+  fmt::print("checksum {}\n", checksum);
+  return 0;
+}
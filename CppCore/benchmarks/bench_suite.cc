@@ -0,0 +1,222 @@
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include <fmt/format.h>
+#include <fmt/os.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "xtensor/xarray.hpp"
+#include "xtensor/xtensor.hpp"
+
+#include "rgpot/CuH2/CuH2Pot.hpp"
+#include "xtsci/func/plot_aid.hpp"
+#include "xtsci/func/trial/D2/branin.hpp"
+#include "xtsci/func/trial/D2/eggholder.hpp"
+#include "xtsci/func/trial/D2/himmelblau.hpp"
+#include "xtsci/func/trial/D2/mullerbrown.hpp"
+#include "xtsci/func/trial/D2/rosenbrock.hpp"
+#include "xtsci/pot/base.hpp"
+
+// Latency and throughput of the public API, written as JSON so runs from
+// different releases can be diffed. Every trial function is timed through
+// single point f, \nabla f and \nabla^2 f calls and the batched f and \nabla f
+// paths, followed by eval_on_grid2D and XTPot on cuh2.con. Run from
+// CppCore/tests/data (meson does this), the JSON goes to the file named by
+// the first argument or to stdout.
+
+namespace {
+
+constexpr size_t n_repeats = 7;
+// Distinct points cycled through by single point calls, so that the
+// evaluation cache never answers
+constexpr size_t n_distinct = 64;
+constexpr size_t n_batch    = size_t{1} << 14;
+
+struct Record {
+  std::string group;
+  std::string name;
+  std::string dtype;
+  std::string eval;
+  size_t items; // Calls or points per timed run
+  double best_s;
+};
+
+// Best of n_repeats wall times for fn, in seconds
+template <class Fn> double best_time(Fn &&fn) {
+  double best = 0;
+  for (size_t rep = 0; rep < n_repeats; ++rep) {
+    const auto start = std::chrono::steady_clock::now();
+    fn();
+    const std::chrono::duration<double> elapsed
+        = std::chrono::steady_clock::now() - start;
+    best = rep == 0 ? elapsed.count() : std::min(best, elapsed.count());
+  }
+  return best;
+}
+
+template <typename ScalarType>
+xt::xtensor<ScalarType, 2> random_points(
+    size_t n_points, size_t ndim, double lo, double hi) {
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> dist(lo, hi);
+  xt::xtensor<ScalarType, 2> pts = xt::empty<ScalarType>({n_points, ndim});
+  for (auto &val : pts) {
+    val = static_cast<ScalarType>(dist(rng));
+  }
+  return pts;
+}
+
+template <typename ScalarType>
+std::vector<xt::xarray<ScalarType>>
+split_rows(const xt::xtensor<ScalarType, 2> &pts) {
+  std::vector<xt::xarray<ScalarType>> rows;
+  rows.reserve(pts.shape(0));
+  for (size_t idx = 0; idx < pts.shape(0); ++idx) {
+    rows.emplace_back(xt::row(pts, idx));
+  }
+  return rows;
+}
+
+// Single point calls of f, \nabla f and \nabla^2 f, then the batched paths
+template <typename ScalarType>
+void bench_objective(
+    const xts::func::ObjectiveFunction<ScalarType> &func,
+    const std::string &group, const std::string &name,
+    const std::string &dtype, const xt::xtensor<ScalarType, 2> &batch,
+    bool with_hessian, std::vector<Record> &records, double &checksum) {
+  const size_t n_points = std::min(n_distinct, batch.shape(0));
+  const auto points     = split_rows<ScalarType>(
+      xt::view(batch, xt::range(0, n_points), xt::all()));
+  const size_t n_calls = n_points * 16;
+
+  auto single = [&](const std::string &eval, auto &&call) {
+    const double secs = best_time([&] {
+      for (size_t idx = 0; idx < n_calls; ++idx) {
+        checksum += call(points[idx % n_points]);
+      }
+    });
+    records.push_back({group, name, dtype, eval, n_calls, secs});
+  };
+  single("f", [&](const auto &x) { return double(func(x)); });
+  single("grad", [&](const auto &x) {
+    return double(func.gradient(x)->flat(0));
+  });
+  if (with_hessian) {
+    single("hess", [&](const auto &x) {
+      return double(func.hessian(x)->flat(0));
+    });
+  }
+
+  const size_t n_rows = batch.shape(0);
+  const double f_secs = best_time(
+      [&] { checksum += func.evaluate_batch(batch)(n_rows - 1); });
+  records.push_back({group, name, dtype, "f_batch", n_rows, f_secs});
+  const double g_secs = best_time(
+      [&] { checksum += (*func.gradient_batch(batch))(n_rows - 1, 0); });
+  records.push_back({group, name, dtype, "grad_batch", n_rows, g_secs});
+}
+
+template <template <typename> class Trial, typename ScalarType>
+void bench_trial(
+    const std::string &name, const std::string &dtype, double lo, double hi,
+    std::vector<Record> &records, double &checksum) {
+  Trial<ScalarType> func;
+  const auto batch = random_points<ScalarType>(n_batch, 2, lo, hi);
+  bench_objective<ScalarType>(
+      func, "trial", name, dtype, batch, true, records, checksum);
+}
+
+void bench_grids(std::vector<Record> &records, double &checksum) {
+  xts::func::trial::D2::MullerBrown<double> func;
+  const std::function<double(double, double)> wrapped
+      = [&](double x_val, double y_val) { return func(x_val, y_val); };
+  for (const size_t n_side : {64, 256, 1024}) {
+    const std::array<double, 3> x_axis = {-1.5, 1.2, double(n_side)};
+    const std::array<double, 3> y_axis = {-0.2, 2.0, double(n_side)};
+    const double secs                  = best_time([&] {
+      checksum += xts::func::eval_on_grid2D<double>(x_axis, y_axis, wrapped)(
+          n_side - 1, n_side - 1);
+    });
+    records.push_back(
+        {"grid", fmt::format("MullerBrown/{}x{}", n_side, n_side), "double",
+         "eval_on_grid2D", n_side * n_side, secs});
+  }
+}
+
+void bench_xtpot(std::vector<Record> &records, double &checksum) {
+  auto func = xts::pot::mk_xtpot_con(
+      "cuh2.con", std::make_shared<rgpot::CuH2Pot>());
+  auto [positions, atomTypes, boxMatrix, booltypes]
+      = xts::pot::extract_condat("cuh2.con");
+  const xt::xtensor<double, 1> free_x = func.get_free(positions);
+  // Rattled copies of the free coordinates
+  xt::xtensor<double, 2> batch = random_points<double>(
+      size_t{256}, free_x.size(), -0.05, 0.05);
+  batch += free_x;
+  // Hessians of the potential are finite differences, left out here
+  bench_objective<double>(
+      func, "xtpot", "CuH2", "double", batch, false, records, checksum);
+}
+
+std::string to_json(const std::vector<Record> &records) {
+  std::string out = "{\n";
+#ifdef XTSCI_USE_XSIMD
+  out += "  \"simd\": true,\n";
+#else
+  out += "  \"simd\": false,\n";
+#endif
+  out += fmt::format("  \"repeats\": {},\n  \"results\": [\n", n_repeats);
+  for (size_t idx = 0; idx < records.size(); ++idx) {
+    const Record &rec = records[idx];
+    out += fmt::format(
+        "    {{\"group\": \"{}\", \"name\": \"{}\", \"dtype\": \"{}\", "
+        "\"eval\": \"{}\", \"items\": {}, \"ns_per_item\": {:.6g}, "
+        "\"items_per_s\": {:.6g}}}{}\n",
+        rec.group, rec.name, rec.dtype, rec.eval, rec.items,
+        1e9 * rec.best_s / rec.items, rec.items / rec.best_s,
+        idx + 1 < records.size() ? "," : "");
+  }
+  out += "  ]\n}\n";
+  return out;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  namespace D2    = xts::func::trial::D2;
+  double checksum = 0;
+  std::vector<Record> records;
+  bench_trial<D2::Rosenbrock, double>(
+      "Rosenbrock", "double", -2.0, 2.0, records, checksum);
+  bench_trial<D2::Himmelblau, double>(
+      "Himmelblau", "double", -5.0, 5.0, records, checksum);
+  bench_trial<D2::MullerBrown, double>(
+      "MullerBrown", "double", -1.5, 2.0, records, checksum);
+  bench_trial<D2::MullerBrown, float>(
+      "MullerBrown", "float", -1.5, 2.0, records, checksum);
+  bench_trial<D2::Branin, double>(
+      "Branin", "double", -5.0, 15.0, records, checksum);
+  bench_trial<D2::Eggholder, double>(
+      "Eggholder", "double", -512, 512, records, checksum);
+  bench_grids(records, checksum);
+  bench_xtpot(records, checksum);
+
+  const std::string json = to_json(records);
+  if (argc > 1) {
+    auto out = fmt::output_file(argv[1]);
+    out.print("{}", json);
+  } else {
+    fmt::print("{}", json);
+  }
+  // Keeps the timed loops from being optimised away
+  fmt::print(stderr, "checksum {}\n", checksum);
+  return 0;
+}
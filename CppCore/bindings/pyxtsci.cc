@@ -0,0 +1,281 @@
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <pybind11/functional.h>
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#define FORCE_IMPORT_ARRAY
+#include "xtensor-python/pyarray.hpp"
+#include "xtensor-python/pytensor.hpp"
+
+#include "rgpot/CuH2/CuH2Pot.hpp"
+#include "xtsci/func/base.hpp"
+#include "xtsci/func/plot_aid.hpp"
+#include "xtsci/func/trial/D2/branin.hpp"
+#include "xtsci/func/trial/D2/eggholder.hpp"
+#include "xtsci/func/trial/D2/himmelblau.hpp"
+#include "xtsci/func/trial/D2/mullerbrown.hpp"
+#include "xtsci/func/trial/D2/rosenbrock.hpp"
+#include "xtsci/pot/base.hpp"
+#include "xtsci/pot/snapshot.hpp"
+
+// Python module pyxtsci. NumPy arguments arrive as xtensor-python containers
+// over the NumPy buffer; batch points are gathered into one contiguous
+// xtensor per call rather than one conversion per point. Results are moved
+// into heap xtensors owned by the returned NumPy arrays, so nothing is copied
+// on the way out. Batch and grid evaluations run without the GIL.
+
+namespace py = pybind11;
+
+namespace {
+
+using Scalar    = double;
+using Objective = xts::func::ObjectiveFunction<Scalar>;
+using Pot       = xts::pot::XTPot<Scalar>;
+
+// NumPy array viewing a container it takes ownership of
+template <class Container> py::array_t<Scalar> to_numpy(Container &&values) {
+  auto *owned = new Container(std::move(values));
+  py::capsule base(
+      owned, [](void *ptr) { delete static_cast<Container *>(ptr); });
+  std::vector<py::ssize_t> shape(owned->shape().begin(), owned->shape().end());
+  std::vector<py::ssize_t> strides;
+  for (const auto stride : owned->strides()) {
+    strides.push_back(stride * static_cast<py::ssize_t>(sizeof(Scalar)));
+  }
+  return py::array_t<Scalar>(shape, strides, owned->data(), base);
+}
+
+template <class Container>
+std::optional<py::array_t<Scalar>>
+to_numpy(std::optional<Container> &&values) {
+  if (!values) {
+    return std::nullopt;
+  }
+  return to_numpy(std::move(*values));
+}
+
+void bind_objective(py::module_ &mod) {
+  using Counter = xts::func::EvaluationCounter;
+  py::class_<Counter>(mod, "EvaluationCounter")
+      .def_readonly("function_evals", &Counter::function_evals)
+      .def_readonly("gradient_evals", &Counter::gradient_evals)
+      .def_readonly("hessian_evals", &Counter::hessian_evals)
+      .def_readonly("unique_func_grad_hess", &Counter::unique_func_grad_hess)
+      .def_readonly("cache_hits", &Counter::cache_hits)
+      .def_readonly("cache_misses", &Counter::cache_misses);
+
+  py::class_<Objective, std::shared_ptr<Objective>>(mod, "ObjectiveFunction")
+      .def(
+          "__call__",
+          [](const Objective &func, const xt::pyarray<Scalar> &x) {
+            return func(x);
+          },
+          py::arg("x"))
+      .def(
+          "gradient",
+          [](const Objective &func, const xt::pyarray<Scalar> &x,
+             bool zero_fixed) {
+            return to_numpy(func.gradient(x, zero_fixed));
+          },
+          py::arg("x"), py::arg("zero_fixed") = false)
+      .def(
+          "hessian",
+          [](const Objective &func, const xt::pyarray<Scalar> &x,
+             bool zero_fixed) {
+            return to_numpy(func.hessian(x, zero_fixed));
+          },
+          py::arg("x"), py::arg("zero_fixed") = false)
+      .def(
+          "value_and_gradient",
+          [](const Objective &func, const xt::pyarray<Scalar> &x,
+             bool zero_fixed) {
+            auto [fval, grad] = func.value_and_gradient(x, zero_fixed);
+            return std::make_pair(fval, to_numpy(std::move(grad)));
+          },
+          py::arg("x"), py::arg("zero_fixed") = false)
+      .def(
+          "hessian_vector_product",
+          [](const Objective &func, const xt::pyarray<Scalar> &x,
+             const xt::pyarray<Scalar> &v, bool zero_fixed) {
+            const xt::xarray<Scalar> point = x;
+            const xt::xarray<Scalar> dir   = v;
+            std::optional<xt::xarray<Scalar>> prod;
+            {
+              py::gil_scoped_release release;
+              prod = func.hessian_vector_product(point, dir, zero_fixed);
+            }
+            return to_numpy(std::move(prod));
+          },
+          py::arg("x"), py::arg("v"), py::arg("zero_fixed") = false)
+      .def(
+          "evaluate_batch",
+          [](const Objective &func, const xt::pytensor<Scalar, 2> &pts) {
+            const xt::xtensor<Scalar, 2> points = pts;
+            xt::xtensor<Scalar, 1> vals;
+            {
+              py::gil_scoped_release release;
+              vals = func.evaluate_batch(points);
+            }
+            return to_numpy(std::move(vals));
+          },
+          py::arg("points"))
+      .def(
+          "gradient_batch",
+          [](const Objective &func, const xt::pytensor<Scalar, 2> &pts,
+             bool zero_fixed) {
+            const xt::xtensor<Scalar, 2> points = pts;
+            std::optional<xt::xtensor<Scalar, 2>> grads;
+            {
+              py::gil_scoped_release release;
+              grads = func.gradient_batch(points, zero_fixed);
+            }
+            return to_numpy(std::move(grads));
+          },
+          py::arg("points"), py::arg("zero_fixed") = false)
+      .def(
+          "value_and_gradient_batch",
+          [](const Objective &func, const xt::pytensor<Scalar, 2> &pts,
+             bool zero_fixed) {
+            const xt::xtensor<Scalar, 2> points = pts;
+            std::pair<
+                xt::xtensor<Scalar, 1>, std::optional<xt::xtensor<Scalar, 2>>>
+                result;
+            {
+              py::gil_scoped_release release;
+              result = func.value_and_gradient_batch(points, zero_fixed);
+            }
+            return std::make_pair(
+                to_numpy(std::move(result.first)),
+                to_numpy(std::move(result.second)));
+          },
+          py::arg("points"), py::arg("zero_fixed") = false)
+      .def(
+          "enable_finite_differences",
+          [](Objective &func, Scalar step, size_t n_threads) {
+            xts::func::FDOptions<Scalar> opts;
+            opts.step      = step;
+            opts.n_threads = n_threads;
+            func.enable_finite_differences(opts);
+          },
+          py::arg("step") = 0, py::arg("n_threads") = 0)
+      .def("evaluation_counts", &Objective::evaluation_counts)
+      .def("clear_cache", &Objective::clear_cache)
+      .def_property_readonly(
+          "minima",
+          [](const Objective &func) {
+            return to_numpy(xt::xarray<Scalar>(func.minima));
+          })
+      .def_property_readonly("saddles", [](const Objective &func) {
+        return to_numpy(xt::xarray<Scalar>(func.saddles));
+      });
+
+  // z(i, j) = f(x_i, y_j) over (lo, hi, n) axes, batched rows across
+  // n_threads (0 for the hardware concurrency)
+  mod.def(
+      "grid2d",
+      [](const Objective &func, const std::array<Scalar, 3> &x_axis,
+         const std::array<Scalar, 3> &y_axis, size_t n_threads) {
+        xt::xtensor<Scalar, 2> grid;
+        {
+          py::gil_scoped_release release;
+          grid = xts::func::eval_on_grid2D<Scalar>(
+              x_axis, y_axis, func, n_threads);
+        }
+        return to_numpy(std::move(grid));
+      },
+      py::arg("func"), py::arg("x_axis"), py::arg("y_axis"),
+      py::arg("n_threads") = 0);
+}
+
+template <class Trial>
+void bind_trial(py::module_ &mod, const char *name) {
+  py::class_<Trial, Objective, std::shared_ptr<Trial>>(mod, name)
+      .def(
+          py::init([](const std::optional<xt::pytensor<bool, 1>> &is_fixed) {
+            if (!is_fixed) {
+              return std::make_shared<Trial>();
+            }
+            return std::make_shared<Trial>(xt::xtensor<bool, 1>(*is_fixed));
+          }),
+          py::arg("is_fixed") = std::nullopt);
+}
+
+void bind_xtpot(py::module_ &mod) {
+  py::class_<rgpot::Potential, std::shared_ptr<rgpot::Potential>>(
+      mod, "Potential");
+  using CuH2 = rgpot::CuH2Pot;
+  py::class_<CuH2, rgpot::Potential, std::shared_ptr<CuH2>>(mod, "CuH2Pot")
+      .def(py::init<>());
+
+  py::class_<Pot, Objective, std::shared_ptr<Pot>>(mod, "XTPot")
+      .def_static(
+          "from_con",
+          [](const std::string &con_fname,
+             std::shared_ptr<rgpot::Potential> pot) {
+            return std::make_shared<Pot>(
+                xts::pot::mk_xtpot_con(con_fname, std::move(pot)));
+          },
+          py::arg("con_fname"), py::arg("potential"))
+      .def_static(
+          "from_snapshot",
+          [](const std::string &snap_fname,
+             std::shared_ptr<rgpot::Potential> pot) {
+            return std::make_shared<Pot>(
+                xts::pot::mk_xtpot_snapshot(snap_fname, std::move(pot)));
+          },
+          py::arg("snap_fname"), py::arg("potential"))
+      .def(
+          "get_free",
+          [](const Pot &pot, const xt::pyarray<Scalar> &positions) {
+            return to_numpy(pot.get_free(positions));
+          },
+          py::arg("positions"))
+      .def_property_readonly("n_atoms", &Pot::n_atoms)
+      .def_property_readonly("n_free", &Pot::n_free)
+      // factory() makes one potential per worker, it is only called here,
+      // with the GIL held
+      .def(
+          "enable_parallel_batches",
+          [](Pot &pot, const py::function &factory, size_t n_threads) {
+            pot.enable_parallel_batches(
+                [&]() {
+                  return factory().cast<std::shared_ptr<rgpot::Potential>>();
+                },
+                n_threads);
+          },
+          py::arg("factory"), py::arg("n_threads") = 0)
+      .def("disable_parallel_batches", &Pot::disable_parallel_batches)
+      .def_property_readonly("parallel_batches", &Pot::parallel_batches);
+
+  mod.def(
+      "con_to_snapshot", &xts::pot::con_to_snapshot, py::arg("con_fname"),
+      py::arg("snap_fname"));
+  mod.def(
+      "snapshot_to_con", &xts::pot::snapshot_to_con, py::arg("snap_fname"),
+      py::arg("con_fname"));
+}
+
+} // namespace
+
+PYBIND11_MODULE(pyxtsci, mod) {
+  xt::import_numpy();
+  mod.doc() = "xtsci-function objective functions and potentials";
+  bind_objective(mod);
+  namespace D2 = xts::func::trial::D2;
+  bind_trial<D2::Rosenbrock<Scalar>>(mod, "Rosenbrock");
+  bind_trial<D2::Himmelblau<Scalar>>(mod, "Himmelblau");
+  bind_trial<D2::MullerBrown<Scalar>>(mod, "MullerBrown");
+  bind_trial<D2::Branin<Scalar>>(mod, "Branin");
+  bind_trial<D2::Eggholder<Scalar>>(mod, "Eggholder");
+  bind_xtpot(mod);
+}
@@ -0,0 +1,91 @@
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include "xtsci/func/autodiff.hpp"
+#include "xtsci/func/trial/D2/autodiff2d.hpp"
+#include "xtsci/func/trial/D2/branin.hpp"
+#include "xtsci/func/trial/D2/eggholder.hpp"
+#include "xtsci/func/trial/D2/himmelblau.hpp"
+#include "xtsci/func/trial/D2/mullerbrown.hpp"
+#include "xtsci/func/trial/D2/rosenbrock.hpp"
+#include <catch2/catch_all.hpp>
+
+using Scalar = double;
+namespace ad = xts::func::autodiff;
+
+TEST_CASE("Dual number arithmetic", "[AutoDiff]") {
+  using HD = ad::HyperDual<Scalar, 2>;
+  const HD x_var = HD::variable(0.5, 0);
+  const HD y_var = HD::variable(2.0, 1);
+
+  SECTION("Products and quotients") {
+    // f = x y / (1 + x)
+    const HD fval = x_var * y_var / (Scalar{1} + x_var);
+    REQUIRE_THAT(fval.val, Catch::Matchers::WithinAbs(1.0 / 1.5, 1e-14));
+    // df/dx = y / (1 + x)^2, df/dy = x / (1 + x)
+    REQUIRE_THAT(fval.grad[0], Catch::Matchers::WithinAbs(2.0 / 2.25, 1e-14));
+    REQUIRE_THAT(fval.grad[1], Catch::Matchers::WithinAbs(0.5 / 1.5, 1e-14));
+    // d2f/dx2 = -2 y / (1 + x)^3, d2f/dxdy = 1 / (1 + x)^2, d2f/dy2 = 0
+    REQUIRE_THAT(
+        fval.hess[0][0], Catch::Matchers::WithinAbs(-4.0 / 3.375, 1e-14));
+    REQUIRE_THAT(fval.hess[0][1], Catch::Matchers::WithinAbs(1 / 2.25, 1e-14));
+    REQUIRE(fval.hess[0][1] == fval.hess[1][0]);
+    REQUIRE_THAT(fval.hess[1][1], Catch::Matchers::WithinAbs(0.0, 1e-14));
+  }
+
+  SECTION("Elementary functions") {
+    // f = exp(x) sin(y) + sqrt(x)
+    const HD fval = exp(x_var) * sin(y_var) + sqrt(x_var);
+    REQUIRE_THAT(
+        fval.grad[0], Catch::Matchers::WithinAbs(
+                          std::exp(0.5) * std::sin(2.0) + 0.5 / std::sqrt(0.5),
+                          1e-14));
+    REQUIRE_THAT(
+        fval.grad[1],
+        Catch::Matchers::WithinAbs(std::exp(0.5) * std::cos(2.0), 1e-14));
+    REQUIRE_THAT(
+        fval.hess[0][0], Catch::Matchers::WithinAbs(
+                             std::exp(0.5) * std::sin(2.0)
+                                 - 0.25 * std::pow(0.5, -1.5),
+                             1e-14));
+    REQUIRE_THAT(
+        fval.hess[1][1],
+        Catch::Matchers::WithinAbs(-std::exp(0.5) * std::sin(2.0), 1e-14));
+  }
+}
+
+// The AD derivatives must agree with the hand written kernels
+template <template <typename> class Trial> void check_against_kernels() {
+  xts::func::trial::D2::AutoDiff2D<Trial, Scalar> autodiff;
+  Trial<Scalar> analytic;
+  for (const xt::xarray<Scalar> &x :
+       {xt::xarray<Scalar>{0.3, 0.7}, xt::xarray<Scalar>{-1.05, 0.466},
+        xt::xarray<Scalar>{1.623, 0.38}}) {
+    REQUIRE_THAT(autodiff(x), Catch::Matchers::WithinAbs(analytic(x), 1e-12));
+    REQUIRE(xt::allclose(*autodiff.gradient(x), *analytic.gradient(x)));
+    REQUIRE(xt::allclose(*autodiff.hessian(x), *analytic.hessian(x)));
+  }
+}
+
+TEST_CASE("AutoDiff2D matches the analytic derivatives", "[AutoDiff]") {
+  using namespace xts::func::trial::D2;
+  SECTION("Rosenbrock") { check_against_kernels<Rosenbrock>(); }
+  SECTION("Himmelblau") { check_against_kernels<Himmelblau>(); }
+  SECTION("Branin") { check_against_kernels<Branin>(); }
+  SECTION("MullerBrown") { check_against_kernels<MullerBrown>(); }
+  SECTION("Eggholder") { check_against_kernels<Eggholder>(); }
+}
+
+TEST_CASE("AutoDiff2D single pass evaluation", "[AutoDiff]") {
+  xts::func::trial::D2::AutoDiff2D<xts::func::trial::D2::MullerBrown, Scalar>
+      mullerbrown;
+  xt::xarray<Scalar> x    = {-0.558, 1.442};
+  auto [fval, grad, hess] = mullerbrown.value_gradient_hessian(x);
+  REQUIRE_THAT(fval, Catch::Matchers::WithinAbs(-146.69948920058778, 1e-4));
+  REQUIRE(grad->size() == 2);
+  REQUIRE(hess->shape(0) == 2);
+  REQUIRE(mullerbrown.evaluation_counts().unique_func_grad_hess == 1);
+  xt::xarray<Scalar> other = {0.1, 0.2};
+  auto grads = mullerbrown.gradient_batch(xt::xtensor<Scalar, 2>{{0.1, 0.2}});
+  REQUIRE(xt::allclose(
+      xt::view(*grads, 0, xt::all()), *mullerbrown.gradient(other)));
+}
@@ -0,0 +1,136 @@
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include "xtsci/func/trial/D2/branin.hpp"
+#include "xtsci/func/trial/D2/eggholder.hpp"
+#include "xtsci/func/trial/D2/himmelblau.hpp"
+#include "xtsci/func/trial/D2/mullerbrown.hpp"
+#include "xtsci/func/trial/D2/rosenbrock.hpp"
+#include <catch2/catch_all.hpp>
+
+using Scalar = double;
+
+// Batches must agree with the single point path row by row
+template <class Func>
+void check_batch_matches(const Func &func, bool has_gradient = true) {
+  xt::xtensor<Scalar, 2> pts = {
+      {0.0, 0.0}, {1.0, 1.0}, {-1.05, 0.466}, {1.623, 0.38}, {2.0, -2.0}};
+  auto vals = func.evaluate_batch(pts);
+  REQUIRE(vals.size() == pts.shape(0));
+  for (size_t idx = 0; idx < pts.shape(0); ++idx) {
+    xt::xarray<Scalar> point = xt::row(pts, idx);
+    REQUIRE_THAT(vals(idx), Catch::Matchers::WithinAbs(func(point), 1e-10));
+  }
+  auto grads = func.gradient_batch(pts);
+  REQUIRE(grads.has_value() == has_gradient);
+  if (has_gradient) {
+    REQUIRE(grads->shape(0) == pts.shape(0));
+    REQUIRE(grads->shape(1) == 2);
+    for (size_t idx = 0; idx < pts.shape(0); ++idx) {
+      xt::xarray<Scalar> point = xt::row(pts, idx);
+      auto grad                = func.gradient(point).value();
+      REQUIRE_THAT(
+          (*grads)(idx, 0), Catch::Matchers::WithinAbs(grad(0), 1e-10));
+      REQUIRE_THAT(
+          (*grads)(idx, 1), Catch::Matchers::WithinAbs(grad(1), 1e-10));
+    }
+  }
+  auto [fused_vals, fused_grads] = func.value_and_gradient_batch(pts);
+  REQUIRE(xt::allclose(fused_vals, vals));
+  REQUIRE(fused_grads.has_value() == has_gradient);
+  if (has_gradient) {
+    REQUIRE(xt::allclose(*fused_grads, *grads));
+  }
+}
+
+TEST_CASE("Batched evaluation matches single points", "[Batch]") {
+  SECTION("Rosenbrock") {
+    check_batch_matches(xts::func::trial::D2::Rosenbrock<Scalar>{});
+  }
+  SECTION("Himmelblau") {
+    check_batch_matches(xts::func::trial::D2::Himmelblau<Scalar>{});
+  }
+  SECTION("Branin") {
+    check_batch_matches(xts::func::trial::D2::Branin<Scalar>{});
+  }
+  SECTION("MullerBrown") {
+    check_batch_matches(xts::func::trial::D2::MullerBrown<Scalar>{});
+  }
+  SECTION("Eggholder") {
+    check_batch_matches(xts::func::trial::D2::Eggholder<Scalar>{});
+  }
+}
+
+TEST_CASE("Batches reject points of the wrong width", "[Batch]") {
+  xts::func::trial::D2::Rosenbrock<Scalar> rosen;
+  const xt::xtensor<Scalar, 2> narrow = {{0.5}, {1.0}};
+  const xt::xtensor<Scalar, 2> wide   = {{0.5, 1.0, 2.0}};
+  REQUIRE_THROWS_AS(rosen.evaluate_batch(narrow), std::invalid_argument);
+  REQUIRE_THROWS_AS(rosen.gradient_batch(narrow), std::invalid_argument);
+  REQUIRE_THROWS_AS(
+      rosen.value_and_gradient_batch(wide), std::invalid_argument);
+
+  SECTION("Fixed coordinates still take a column") {
+    xts::func::trial::D2::Branin<Scalar> branin(
+        xt::xtensor<bool, 1>{true, false});
+    REQUIRE_THROWS_AS(branin.evaluate_batch(narrow), std::invalid_argument);
+    REQUIRE_THROWS_AS(branin.gradient_batch(narrow), std::invalid_argument);
+    const xt::xtensor<Scalar, 2> full = {{0.5, 1.0}};
+    REQUIRE_NOTHROW(branin.evaluate_batch(full));
+  }
+}
+
+// Odd sized batches exercise both the packed (SIMD) loop and the scalar tail
+template <template <typename> class Trial, typename ScalarType>
+void check_packed_matches_kernels(ScalarType rel_tol) {
+  const size_t npts              = 37;
+  xt::xtensor<ScalarType, 2> pts = xt::empty<ScalarType>({npts, size_t{2}});
+  for (size_t idx = 0; idx < npts; ++idx) {
+    pts(idx, 0) = static_cast<ScalarType>(-1.4 + 0.07 * idx);
+    pts(idx, 1) = static_cast<ScalarType>(1.9 - 0.05 * idx);
+  }
+  Trial<ScalarType> func;
+  auto vals  = func.evaluate_batch(pts);
+  auto grads = func.gradient_batch(pts).value();
+  for (size_t idx = 0; idx < npts; ++idx) {
+    const ScalarType x_val = pts(idx, 0);
+    const ScalarType y_val = pts(idx, 1);
+    auto [df_dx, df_dy]    = Trial<ScalarType>::gradient_kernel(x_val, y_val);
+    REQUIRE_THAT(
+        vals(idx), Catch::Matchers::WithinRel(
+                       Trial<ScalarType>::value_kernel(x_val, y_val), rel_tol));
+    REQUIRE_THAT(grads(idx, 0), Catch::Matchers::WithinRel(df_dx, rel_tol));
+    REQUIRE_THAT(grads(idx, 1), Catch::Matchers::WithinRel(df_dy, rel_tol));
+  }
+}
+
+TEST_CASE("Packed batches match the scalar kernels", "[Batch]") {
+  using namespace xts::func::trial::D2;
+  SECTION("double") {
+    check_packed_matches_kernels<MullerBrown, double>(1e-12);
+    check_packed_matches_kernels<Branin, double>(1e-12);
+    check_packed_matches_kernels<Eggholder, double>(1e-12);
+  }
+  SECTION("float") {
+    check_packed_matches_kernels<MullerBrown, float>(1e-4f);
+    check_packed_matches_kernels<Branin, float>(1e-4f);
+    check_packed_matches_kernels<Eggholder, float>(1e-4f);
+  }
+}
+
+TEST_CASE("Batched evaluation bookkeeping", "[Batch]") {
+  xt::xtensor<bool, 1> fixedMask = {false, true};
+  xts::func::trial::D2::Rosenbrock<Scalar> rosen(fixedMask);
+  xt::xtensor<Scalar, 2> pts = {{0.0, 0.0}, {1.0, 2.0}, {0.3, 2.0}};
+
+  SECTION("Counters advance by the number of points") {
+    rosen.evaluate_batch(pts);
+    REQUIRE(rosen.evaluation_counts().function_evals == 3);
+    rosen.gradient_batch(pts);
+    REQUIRE(rosen.evaluation_counts().gradient_evals == 3);
+  }
+
+  SECTION("Fixed degrees of freedom are zeroed per column") {
+    auto grads = rosen.gradient_batch(pts, true).value();
+    REQUIRE(xt::all(xt::equal(xt::view(grads, xt::all(), 1), 0.0)));
+  }
+}
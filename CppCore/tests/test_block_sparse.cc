@@ -0,0 +1,151 @@
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include "xtsci/func/block_sparse.hpp"
+#include <catch2/catch_all.hpp>
+
+using Scalar = double;
+using xts::func::BlockSparseHessian;
+using xts::func::FDOptions;
+
+// Harmonic springs between consecutive sites of a chain, so each site only
+// couples to its two neighbours along the chain
+class SpringChain : public xts::func::ObjectiveFunction<Scalar> {
+public:
+  explicit SpringChain(size_t n_sites)
+      : xts::func::ObjectiveFunction<Scalar>(3 * n_sites), m_sites(n_sites) {}
+
+  // Slightly perturbed sites 1.2 apart along x
+  xt::xarray<Scalar> start() const {
+    xt::xarray<Scalar> x = xt::zeros<Scalar>({3 * m_sites});
+    for (size_t site = 0; site < m_sites; ++site) {
+      const auto phase = static_cast<Scalar>(site);
+      x(3 * site)      = 1.2 * phase + 0.1 * std::sin(phase);
+      x(3 * site + 1)  = 0.2 * std::cos(2 * phase);
+      x(3 * site + 2)  = 0.1 * std::sin(3 * phase);
+    }
+    return x;
+  }
+
+private:
+  size_t m_sites;
+
+  Scalar stretch(const xt::xarray<Scalar> &x, size_t site) const {
+    Scalar dist_sq = 0;
+    for (size_t ax = 0; ax < 3; ++ax) {
+      const Scalar delta = x(3 * site + ax) - x(3 * site + 3 + ax);
+      dist_sq += delta * delta;
+    }
+    return std::sqrt(dist_sq);
+  }
+
+  Scalar compute(const xt::xarray<Scalar> &x) const override {
+    Scalar energy = 0;
+    for (size_t site = 0; site + 1 < m_sites; ++site) {
+      const Scalar extension = this->stretch(x, site) - 1.0;
+      energy += 0.5 * extension * extension;
+    }
+    return energy;
+  }
+
+  std::optional<xt::xarray<Scalar>>
+  compute_gradient(const xt::xarray<Scalar> &x) const override {
+    xt::xarray<Scalar> grad = xt::zeros<Scalar>(x.shape());
+    for (size_t site = 0; site + 1 < m_sites; ++site) {
+      const Scalar dist  = this->stretch(x, site);
+      const Scalar scale = (dist - 1.0) / dist;
+      for (size_t ax = 0; ax < 3; ++ax) {
+        const Scalar force = scale * (x(3 * site + ax) - x(3 * site + 3 + ax));
+        grad(3 * site + ax) += force;
+        grad(3 * site + 3 + ax) -= force;
+      }
+    }
+    return grad;
+  }
+};
+
+xt::xtensor<Scalar, 2> as_sites(const xt::xarray<Scalar> &x) {
+  const std::array<size_t, 2> shape = {x.size() / 3, 3};
+  xt::xtensor<Scalar, 2> positions   = xt::reshape_view(x, shape);
+  return positions;
+}
+
+TEST_CASE("Neighbour lists", "[BlockSparse]") {
+  SECTION("Cell lists match all pairs") {
+    SpringChain chain(40);
+    const auto positions = as_sites(chain.start());
+    auto neighbours      = xts::func::neighbours_within(positions, 1.5);
+    for (size_t site = 0; site < 40; ++site) {
+      std::sort(neighbours[site].begin(), neighbours[site].end());
+      std::vector<size_t> expected;
+      for (size_t other = 0; other < 40; ++other) {
+        const Scalar dist = xt::linalg::norm(
+            xt::row(positions, site) - xt::row(positions, other));
+        if (other != site && dist <= 1.5) {
+          expected.push_back(other);
+        }
+      }
+      REQUIRE(neighbours[site] == expected);
+    }
+  }
+
+  SECTION("Minimum image") {
+    xt::xtensor<Scalar, 2> positions
+        = {{0.5, 0.0, 0.0}, {3.0, 0.0, 0.0}, {6.0, 0.0, 0.0}, {9.6, 0.0, 0.0}};
+    auto open     = xts::func::neighbours_within(positions, 1.0);
+    auto periodic = xts::func::neighbours_within(
+        positions, 1.0, std::array<Scalar, 3>{10.0, 0.0, 0.0});
+    REQUIRE(open[0].empty());
+    REQUIRE(periodic[0] == std::vector<size_t>{3});
+    REQUIRE(periodic[3] == std::vector<size_t>{0});
+    REQUIRE(periodic[1].empty());
+  }
+}
+
+TEST_CASE("Block sparse Hessians", "[BlockSparse]") {
+  SpringChain chain(12);
+  const auto x = chain.start();
+  FDOptions<Scalar> opts;
+  opts.n_threads = 2;
+  chain.enable_finite_differences(opts);
+  const auto neighbours = xts::func::neighbours_within(as_sites(x), 1.5);
+  auto hess = xts::func::sparse_hessian(chain, x, neighbours).value();
+
+  SECTION("Pattern") {
+    REQUIRE(hess.n_sites() == 12);
+    // Diagonal plus both directions of the eleven springs
+    REQUIRE(hess.n_blocks() == 12 + 2 * 11);
+    REQUIRE(hess.find(0, 1) != nullptr);
+    REQUIRE(hess.find(0, 2) == nullptr);
+    REQUIRE(hess(0, 6) == 0.0);
+  }
+
+  SECTION("Matches the dense Hessian") {
+    const auto dense = hess.to_dense();
+    REQUIRE(dense == xt::transpose(dense));
+    REQUIRE(xt::allclose(dense, chain.hessian(x).value(), 1e-6, 1e-6));
+    xt::xarray<Scalar> vec = xt::linspace<Scalar>(-1.0, 1.0, x.size());
+    REQUIRE(xt::allclose(hess.dot(vec), xt::linalg::dot(dense, vec)));
+  }
+
+  SECTION("Gradient calls do not grow with the system") {
+    auto gradient_calls = [](size_t n_sites) {
+      SpringChain longer(n_sites);
+      const auto pt     = longer.start();
+      const auto before = longer.evaluation_counts();
+      xts::func::sparse_hessian(
+          longer, pt, xts::func::neighbours_within(as_sites(pt), 1.5));
+      return longer.evaluation_counts_since(before).unique_func_grad_hess;
+    };
+    REQUIRE(gradient_calls(20) == gradient_calls(200));
+  }
+
+  SECTION("Sizes are checked") {
+    xt::xarray<Scalar> short_x = xt::zeros<Scalar>({6});
+    REQUIRE_THROWS_AS(
+        xts::func::sparse_hessian(chain, short_x, neighbours),
+        std::invalid_argument);
+    const std::vector<std::vector<size_t>> dangling = {{3}};
+    REQUIRE_THROWS_AS(
+        BlockSparseHessian<Scalar>(dangling), std::invalid_argument);
+  }
+}
@@ -1,5 +1,10 @@
 // MIT License
 // Copyright 2023--present Rohit Goswami <HaoZeke>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <vector>
+
 #include "xtsci/func/trial/D2/rosenbrock.hpp"
 #include <catch2/catch_all.hpp>
 
@@ -90,4 +95,87 @@ TEST_CASE("ObjectiveFunction Caching Mechanism", "[ObjectiveFunctionCache]") {
     REQUIRE(rosenbrock.evaluation_counts().hessian_evals == 1);
     REQUIRE(rosenbrock.evaluation_counts().unique_func_grad_hess == 3);
   }
+
+  SECTION("Hit and miss statistics") {
+    xts::func::trial::D2::Rosenbrock<Scalar> rosenbrock;
+    rosenbrock(x);
+    rosenbrock(x);
+    rosenbrock.gradient(x);
+    rosenbrock.gradient(x);
+    REQUIRE(rosenbrock.evaluation_counts().cache_hits == 2);
+    REQUIRE(rosenbrock.evaluation_counts().cache_misses == 2);
+  }
+
+  SECTION("Moving invalidates the cache") {
+    xts::func::trial::D2::Rosenbrock<Scalar> rosenbrock;
+    xt::xarray<Scalar> y = {0.3, 2.1};
+    rosenbrock(x);
+    rosenbrock(y);
+    rosenbrock(x);
+    REQUIRE(rosenbrock.evaluation_counts().unique_func_grad_hess == 3);
+  }
+
+  SECTION("Tolerance") {
+    xts::func::trial::D2::Rosenbrock<Scalar> rosenbrock;
+    xt::xarray<Scalar> y = {0.3 + 1e-10, 2.0};
+    rosenbrock.set_cache_tolerance(1e-8);
+    rosenbrock(x);
+    rosenbrock(y);
+    REQUIRE(rosenbrock.evaluation_counts().unique_func_grad_hess == 1);
+    rosenbrock.set_cache_tolerance(0.0);
+    rosenbrock(y);
+    REQUIRE(rosenbrock.evaluation_counts().unique_func_grad_hess == 2);
+  }
+
+  SECTION("NaN points never match") {
+    xts::func::trial::D2::Rosenbrock<Scalar> rosenbrock;
+    const Scalar nan        = std::numeric_limits<Scalar>::quiet_NaN();
+    xt::xarray<Scalar> bad  = {nan, 2.0};
+    xt::xarray<Scalar> good = {0.3, 2.0};
+    const Scalar expected   = xts::func::trial::D2::Rosenbrock<Scalar>{}(good);
+    REQUIRE(std::isnan(rosenbrock(bad)));
+    REQUIRE(rosenbrock(good) == expected);
+    REQUIRE(rosenbrock(good) == expected);
+    REQUIRE(std::isnan(rosenbrock(bad)));
+    REQUIRE(rosenbrock.evaluation_counts().unique_func_grad_hess == 3);
+    REQUIRE(rosenbrock.evaluation_counts().cache_hits == 1);
+  }
+
+  SECTION("Clearing drops the entry") {
+    xts::func::trial::D2::Rosenbrock<Scalar> rosenbrock;
+    rosenbrock(x);
+    rosenbrock.clear_cache();
+    rosenbrock(x);
+    REQUIRE(rosenbrock.evaluation_counts().unique_func_grad_hess == 2);
+  }
+
+  SECTION("Threads keep their own entries") {
+    constexpr size_t n_threads = 4;
+    constexpr size_t n_calls   = 100;
+    xts::func::trial::D2::Rosenbrock<Scalar> rosenbrock;
+    std::vector<std::thread> workers;
+    for (size_t tdx = 0; tdx < n_threads; ++tdx) {
+      workers.emplace_back([&rosenbrock, tdx] {
+        const xt::xarray<Scalar> point = {0.1 * tdx, 1.0};
+        for (size_t idx = 0; idx < n_calls; ++idx) {
+          rosenbrock(point);
+        }
+      });
+    }
+    for (auto &worker : workers) {
+      worker.join();
+    }
+    const auto counts = rosenbrock.evaluation_counts();
+    REQUIRE(counts.unique_func_grad_hess == n_threads);
+    REQUIRE(counts.cache_hits == n_threads * (n_calls - 1));
+  }
+
+  SECTION("Disabled cache always recomputes") {
+    xts::func::trial::D2::Rosenbrock<Scalar> rosenbrock;
+    rosenbrock.enable_cache(false);
+    rosenbrock(x);
+    rosenbrock(x);
+    REQUIRE(rosenbrock.evaluation_counts().unique_func_grad_hess == 2);
+    REQUIRE(rosenbrock.evaluation_counts().cache_hits == 0);
+  }
 }
@@ -0,0 +1,108 @@
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include "xtsci/func/composite.hpp"
+#include "xtsci/func/trial/D2/mullerbrown.hpp"
+#include "xtsci/func/trial/D2/rosenbrock.hpp"
+#include <catch2/catch_all.hpp>
+
+using Scalar      = double;
+using MullerBrown = xts::func::trial::D2::MullerBrown<Scalar>;
+using Rosenbrock  = xts::func::trial::D2::Rosenbrock<Scalar>;
+
+TEST_CASE("Composite objectives", "[Composite]") {
+  auto mullerbrown = std::make_shared<MullerBrown>();
+  auto rosenbrock  = std::make_shared<Rosenbrock>();
+  const xt::xarray<Scalar> point = {-0.3, 0.9};
+
+  SECTION("Weighted sums and offsets") {
+    const auto sum = xts::func::compose(mullerbrown)
+                     + 0.5 * xts::func::compose(rosenbrock) + 2.0;
+    REQUIRE(sum.terms().size() == 2);
+    const Scalar expected
+        = (*mullerbrown)(point) + 0.5 * (*rosenbrock)(point) + 2.0;
+    REQUIRE_THAT(sum(point), Catch::Matchers::WithinAbs(expected, 1e-12));
+    const xt::xarray<Scalar> grad
+        = *mullerbrown->gradient(point) + 0.5 * *rosenbrock->gradient(point);
+    REQUIRE(xt::allclose(*sum.gradient(point), grad));
+    const xt::xarray<Scalar> hess
+        = *mullerbrown->hessian(point) + 0.5 * *rosenbrock->hessian(point);
+    REQUIRE(xt::allclose(*sum.hessian(point), hess));
+
+    const auto diff = xts::func::compose(mullerbrown)
+                      - xts::func::compose(mullerbrown);
+    REQUIRE_THAT(diff(point), Catch::Matchers::WithinAbs(0.0, 1e-12));
+  }
+
+  SECTION("Shifted terms") {
+    const xt::xarray<Scalar> x0 = {0.1, -0.2};
+    const auto moved = xts::func::compose(mullerbrown).shifted(x0);
+    const xt::xarray<Scalar> back = point - x0;
+    REQUIRE_THAT(
+        moved(point), Catch::Matchers::WithinAbs((*mullerbrown)(back), 1e-12));
+    REQUIRE(xt::allclose(*moved.gradient(point), *mullerbrown->gradient(back)));
+  }
+
+  SECTION("Restraints") {
+    const auto harmonic = xts::func::compose(mullerbrown)
+                              .restrained(xts::func::harmonic_restraint<Scalar>(
+                                  {0}, {0.5}, 10.0));
+    const Scalar d_x = point(0) - 0.5;
+    const Scalar expected = (*mullerbrown)(point) + 5 * d_x * d_x;
+    REQUIRE_THAT(harmonic(point), Catch::Matchers::WithinAbs(expected, 1e-12));
+    const auto grad = *harmonic.gradient(point);
+    REQUIRE_THAT(
+        grad(0), Catch::Matchers::WithinAbs(
+                     (*mullerbrown->gradient(point))(0) + 10 * d_x, 1e-12));
+    REQUIRE((*harmonic.hessian(point))(0, 0)
+            == Catch::Approx((*mullerbrown->hessian(point))(0, 0) + 10));
+
+    // Within the radius the restraint vanishes
+    const auto flat = xts::func::compose(mullerbrown)
+                          .restrained(xts::func::flat_bottom_restraint<Scalar>(
+                              {0, 1}, {-0.3, 0.5}, 10.0, 0.25));
+    const Scalar outside = 0.4 - 0.25;
+    REQUIRE_THAT(
+        flat(point), Catch::Matchers::WithinAbs(
+                         (*mullerbrown)(point) + 5 * outside * outside, 1e-12));
+    REQUIRE_THAT(
+        (*flat.gradient(point))(1),
+        Catch::Matchers::WithinAbs(
+            (*mullerbrown->gradient(point))(1) + 10 * outside, 1e-12));
+  }
+
+  SECTION("Batches and Hessian products agree with single points") {
+    const auto expr = (2.0 * xts::func::compose(mullerbrown))
+                          .shifted(xt::xarray<Scalar>{0.05, 0.0})
+                          .restrained(xts::func::harmonic_restraint<Scalar>(
+                              {1}, {1.0}, 3.0));
+    const xt::xtensor<Scalar, 2> pts = {{-0.3, 0.9}, {0.2, 0.4}, {-0.8, 1.3}};
+    const auto [vals, grads] = expr.value_and_gradient_batch(pts);
+    REQUIRE(grads.has_value());
+    for (size_t row = 0; row < pts.shape(0); ++row) {
+      const xt::xarray<Scalar> x = xt::row(pts, row);
+      REQUIRE_THAT(vals(row), Catch::Matchers::WithinAbs(expr(x), 1e-10));
+      REQUIRE(xt::allclose(xt::row(*grads, row), *expr.gradient(x)));
+    }
+    REQUIRE(xt::allclose(expr.evaluate_batch(pts), vals));
+
+    const xt::xarray<Scalar> dir = {0.3, -0.7};
+    const xt::xarray<Scalar> dense
+        = xt::linalg::dot(*expr.hessian(point), dir);
+    REQUIRE(xt::allclose(*expr.hessian_vector_product(point, dir), dense));
+  }
+
+  SECTION("Counts reach the terms") {
+    const auto sum = xts::func::compose(mullerbrown)
+                     + xts::func::compose(rosenbrock);
+    const auto before = mullerbrown->evaluation_counts();
+    sum.gradient(point);
+    const auto delta = mullerbrown->evaluation_counts_since(before);
+    REQUIRE(delta.gradient_evals == 1);
+    REQUIRE(rosenbrock->evaluation_counts().gradient_evals == 1);
+    // The composite cache answers repeats without touching the terms
+    sum.gradient(point);
+    REQUIRE(
+        mullerbrown->evaluation_counts_since(before).gradient_evals
+        == delta.gradient_evals);
+  }
+}
@@ -0,0 +1,108 @@
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include "rgpot/CuH2/CuH2Pot.hpp"
+#include "xtsci/io/con.hpp"
+#include "xtsci/pot/trajectory.hpp"
+#include <catch2/catch_all.hpp>
+
+// cuh2.con n_frames times, the hydrogens of frame k shifted by 0.01 k in z
+std::string write_trajectory(size_t n_frames) {
+  std::ifstream source("cuh2.con");
+  std::stringstream contents;
+  contents << source.rdbuf();
+  const std::string frame = contents.str();
+  const auto fname
+      = (std::filesystem::temp_directory_path() / "xtsci_traj.con").string();
+  std::ofstream out(fname);
+  for (size_t idx = 0; idx < n_frames; ++idx) {
+    const double shift = 0.01 * idx;
+    const size_t split = frame.find("Coordinates of Component 2");
+    out << frame.substr(0, split) << "Coordinates of Component 2\n";
+    out << "8.6823 9.947 " << 4.7576 + shift << " 0 216\n";
+    out << "7.9421 9.947 " << 4.7576 + shift << " 0 217\n";
+  }
+  return fname;
+}
+
+TEST_CASE("Streaming con frames", "[ConReader]") {
+  auto [positions, atomTypes, boxMatrix, booltypes]
+      = xts::pot::extract_condat("cuh2.con");
+
+  SECTION("A single frame matches extract_condat") {
+    xts::io::ConReader reader("cuh2.con");
+    xts::io::ConFrame frame;
+    REQUIRE(reader.next(frame));
+    REQUIRE(frame.n_atoms() == 218);
+    REQUIRE(frame.symbols == std::vector<std::string>{"Cu", "H"});
+    REQUIRE(frame.counts == std::vector<size_t>{216, 2});
+    REQUIRE(frame.box_lengths[2] == 100.0);
+    REQUIRE(frame.atom_ids.back() == 217);
+    REQUIRE(frame.is_fixed.front());
+    REQUIRE_FALSE(frame.is_fixed.back());
+    REQUIRE(xt::allclose(frame.positions_view(), positions));
+    REQUIRE_FALSE(reader.next(frame));
+    REQUIRE(reader.frames_read() == 1);
+  }
+
+  SECTION("Frames reuse their buffers") {
+    const auto fname = write_trajectory(3);
+    xts::io::ConReader reader(fname);
+    xts::io::ConFrame frame;
+    REQUIRE(reader.next(frame));
+    const double *storage = frame.positions.data();
+    REQUIRE(reader.next(frame));
+    REQUIRE(reader.next(frame));
+    REQUIRE(frame.positions.data() == storage);
+    REQUIRE_THAT(
+        frame.positions.back(), Catch::Matchers::WithinAbs(4.7776, 1e-12));
+    REQUIRE_FALSE(reader.next(frame));
+  }
+
+  SECTION("Malformed frames name the line") {
+    const auto fname
+        = (std::filesystem::temp_directory_path() / "xtsci_bad.con").string();
+    {
+      std::ofstream out(fname);
+      out << "header\nheader\n1.0 1.0 x\n";
+    }
+    xts::io::ConReader reader(fname);
+    xts::io::ConFrame frame;
+    REQUIRE_THROWS_WITH(
+        reader.next(frame), Catch::Matchers::ContainsSubstring(":3: bad"));
+  }
+}
+
+TEST_CASE("Pipelined trajectory scoring", "[ConReader]") {
+  auto cuh2pot     = std::make_shared<rgpot::CuH2Pot>();
+  auto objFunc     = xts::pot::mk_xtpot_con("cuh2.con", cuh2pot);
+  const auto fname = write_trajectory(5);
+  xts::io::ConReader reader(fname);
+  xts::io::ConFrame frame;
+  std::vector<double> expected;
+  while (reader.next(frame)) {
+    xt::xtensor<double, 1> free_x = xt::empty<double>({objFunc.n_free()});
+    objFunc.gather_free(frame.positions.data(), free_x.data());
+    expected.push_back(objFunc(free_x));
+  }
+
+  std::vector<size_t> batch_sizes;
+  std::vector<double> energies;
+  const size_t n_frames = xts::pot::score_trajectory<double>(
+      objFunc, fname, 2, [&](const auto &batch) {
+        REQUIRE(batch.first_frame == energies.size());
+        REQUIRE(batch.gradients.has_value());
+        batch_sizes.push_back(batch.energies.size());
+        energies.insert(
+            energies.end(), batch.energies.begin(), batch.energies.end());
+      });
+  REQUIRE(n_frames == 5);
+  REQUIRE(batch_sizes == std::vector<size_t>{2, 2, 1});
+  for (size_t idx = 0; idx < n_frames; ++idx) {
+    REQUIRE_THAT(
+        energies[idx], Catch::Matchers::WithinAbs(expected[idx], 1e-10));
+  }
+}
@@ -0,0 +1,56 @@
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include <thread>
+#include <vector>
+
+#include "xtsci/func/trial/D2/himmelblau.hpp"
+#include <catch2/catch_all.hpp>
+
+TEST_CASE("Evaluation counters under concurrency", "[Counter]") {
+  using Scalar = double;
+  xts::func::trial::D2::Himmelblau<Scalar> himmelblau;
+  constexpr size_t n_threads = 8;
+  constexpr size_t n_calls   = 500;
+
+  std::vector<std::thread> workers;
+  for (size_t tdx = 0; tdx < n_threads; ++tdx) {
+    workers.emplace_back([&himmelblau, tdx]() {
+      for (size_t idx = 0; idx < n_calls; ++idx) {
+        xt::xarray<Scalar> x = {static_cast<Scalar>(tdx), 0.1 * idx};
+        himmelblau(x);
+        himmelblau.gradient(x);
+      }
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  auto counts = himmelblau.evaluation_counts();
+  REQUIRE(counts.function_evals == n_threads * n_calls);
+  REQUIRE(counts.gradient_evals == n_threads * n_calls);
+  REQUIRE(
+      counts.cache_hits + counts.cache_misses == 2 * n_threads * n_calls);
+}
+
+TEST_CASE("Evaluation counter snapshots", "[Counter]") {
+  using Scalar = double;
+  xts::func::trial::D2::Himmelblau<Scalar> himmelblau;
+  xt::xtensor<Scalar, 2> pts = {{0.0, 0.0}, {1.0, 1.0}};
+
+  himmelblau.evaluate_batch(pts);
+  auto phase_start = himmelblau.evaluation_counts();
+  himmelblau.gradient_batch(pts);
+  auto phase = himmelblau.evaluation_counts_since(phase_start);
+  REQUIRE(phase.function_evals == 0);
+  REQUIRE(phase.gradient_evals == 2);
+
+  auto before = himmelblau.reset_evaluation_counts();
+  REQUIRE(before.function_evals == 2);
+  REQUIRE(himmelblau.evaluation_counts() == xts::func::EvaluationCounter{});
+
+  // Copies carry the counts along
+  himmelblau.evaluate_batch(pts);
+  auto copied = himmelblau;
+  REQUIRE(copied.evaluation_counts().function_evals == 2);
+}
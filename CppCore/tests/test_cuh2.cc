@@ -33,6 +33,113 @@ TEST_CASE("CuH2 Energy and Gradient Calculations", "[CuH2EnergyCalc]") {
     REQUIRE(xt::isclose(*grad, -1 * expected_free_force, TEST_EPS)());
   }
 
+  SECTION("Fused Energy and Gradient Calculation") {
+    xt::xarray<double> free_pos = objFunc.get_free(positions);
+    auto [energy, grad]         = objFunc.value_and_gradient(free_pos);
+    REQUIRE_THAT(
+        energy, Catch::Matchers::WithinAbs(objFunc(free_pos), TEST_EPS));
+    REQUIRE(xt::allclose(*grad, *objFunc.gradient(free_pos)));
+  }
+
+  SECTION("Evaluations only rewrite the free coordinates") {
+    xt::xarray<double> free_pos = objFunc.get_free(positions);
+    const double energy         = objFunc(free_pos);
+    xt::xarray<double> moved    = free_pos + 0.05;
+
+    auto [moved_energy, moved_grad] = objFunc.value_and_gradient(moved);
+    REQUIRE(moved_energy != energy);
+    // The persistent buffers are back at the start, fixed atoms untouched
+    objFunc.clear_cache();
+    REQUIRE_THAT(objFunc(free_pos), Catch::Matchers::WithinAbs(energy, 1e-12));
+    auto copied = objFunc;
+    REQUIRE(xt::allclose(*copied.gradient(moved), *moved_grad));
+    REQUIRE_THROWS_AS(objFunc(positions), std::runtime_error);
+  }
+
+  SECTION("Threaded batches with a potential per worker") {
+    xt::xarray<double> free_pos    = objFunc.get_free(positions);
+    const size_t n_configs         = 12;
+    xt::xtensor<double, 2> configs = xt::empty<double>(
+        {n_configs, free_pos.size()});
+    for (size_t row = 0; row < n_configs; ++row) {
+      xt::row(configs, row) = free_pos + 0.01 * static_cast<double>(row);
+    }
+    auto [serial_energies, serial_grads]
+        = objFunc.value_and_gradient_batch(configs);
+
+    objFunc.enable_parallel_batches(
+        [] { return std::make_shared<rgpot::CuH2Pot>(); }, 4);
+    REQUIRE(objFunc.parallel_batches());
+    auto [energies, grads] = objFunc.value_and_gradient_batch(configs);
+    REQUIRE(xt::allclose(energies, serial_energies, 0.0, 1e-10));
+    REQUIRE(xt::allclose(*grads, *serial_grads, 0.0, 1e-10));
+    REQUIRE(xt::allclose(objFunc.evaluate_batch(configs), energies));
+    REQUIRE(xt::allclose(*objFunc.gradient_batch(configs), *grads));
+    // Rows stay in order
+    for (size_t row = 0; row < n_configs; ++row) {
+      xt::xarray<double> config = xt::row(configs, row);
+      REQUIRE_THAT(
+          energies(row), Catch::Matchers::WithinAbs(objFunc(config), 1e-10));
+    }
+    objFunc.disable_parallel_batches();
+    REQUIRE_FALSE(objFunc.parallel_batches());
+  }
+
+  SECTION("Block sparse Hessian of the free atoms") {
+    xt::xarray<double> free_pos = objFunc.get_free(positions);
+    xts::func::FDOptions<double> serial;
+    serial.n_threads = 1;
+    objFunc.enable_finite_differences(serial);
+    // The hydrogens are 0.74 apart
+    auto hess = objFunc.sparse_hessian(free_pos, 2.0).value();
+    REQUIRE(hess.n_sites() == 2);
+    REQUIRE(hess.n_blocks() == 4);
+    auto dense = objFunc.hessian(free_pos).value();
+    REQUIRE(xt::allclose(hess.to_dense(), dense, 1e-5, 1e-5));
+
+    auto local = objFunc.sparse_hessian(free_pos, 0.5).value();
+    REQUIRE(local.n_blocks() == 2);
+    REQUIRE(local(0, 3) == 0.0);
+    REQUIRE_THAT(local(0, 0), Catch::Matchers::WithinAbs(dense(0, 0), 1e-5));
+  }
+
+  SECTION("Threaded finite differences go through the batch workers") {
+    xt::xarray<double> free_pos = objFunc.get_free(positions);
+    xts::func::FDOptions<double> serial;
+    serial.n_threads = 1;
+    objFunc.enable_finite_differences(serial);
+    const auto dense_serial  = objFunc.hessian(free_pos).value();
+    const auto sparse_serial = objFunc.sparse_hessian(free_pos, 2.0).value();
+
+    objFunc.enable_parallel_batches(
+        [] { return std::make_shared<rgpot::CuH2Pot>(); }, 4);
+    xts::func::FDOptions<double> threaded;
+    threaded.n_threads = 4;
+    objFunc.enable_finite_differences(threaded);
+    const auto before = objFunc.evaluation_counts();
+    const auto dense  = objFunc.hessian(free_pos).value();
+    REQUIRE(xt::allclose(dense, dense_serial, 0.0, 1e-10));
+    // Two central probes per free coordinate, no extra gradient at x
+    REQUIRE(
+        objFunc.evaluation_counts_since(before).unique_func_grad_hess
+        == 1 + 2 * free_pos.size());
+    const auto sparse = objFunc.sparse_hessian(free_pos, 2.0).value();
+    REQUIRE(xt::allclose(
+        sparse.to_dense(), sparse_serial.to_dense(), 0.0, 1e-10));
+  }
+
+  SECTION("Float storage with double evaluation") {
+    auto float_pot = xts::pot::mk_xtpot_con<float>("cuh2.con", cuh2pot);
+    const xt::xarray<float> free_pos
+        = float_pot.get_free(xt::cast<float>(positions));
+    const auto [fval, grad]       = float_pot.value_and_gradient(free_pos);
+    const xt::xarray<double> wide = xt::cast<double>(free_pos);
+    REQUIRE_THAT(fval, Catch::Matchers::WithinRel(objFunc(wide), 1e-6));
+    REQUIRE(grad.has_value());
+    REQUIRE(xt::allclose(
+        xt::cast<double>(*grad), *objFunc.gradient(wide), 1e-5, 1e-6));
+  }
+
   SECTION("Perturbed Energy and Gradient Calculation") {
     auto [hdist, cusdist]
         = rgpot::cuh2::utils::xts::calculateDistances(positions, atomTypes);
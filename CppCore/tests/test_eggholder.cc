@@ -44,22 +44,21 @@ TEST_CASE("Eggholder Function properties", "[Eggholder]") {
         Catch::Matchers::WithinAbs(-26.7590279212, 1e-4));
   }
 
-  // TODO(rgoswami): Fix this
-  // SECTION("Gradient at arbitrary point") {
-  //   x = {0.623, 0.028};
-  //   xt::xarray<Scalar> grad = eggholderFunc.gradient(x).value();
-  //   REQUIRE_THAT(grad(0), Catch::Matchers::WithinAbs(-1.87816053485, 1e-4));
-  //   REQUIRE_THAT(grad(1), Catch::Matchers::WithinAbs(-3.42783757618, 1e-4));
-  // }
+  SECTION("Gradient at arbitrary point") {
+    x = {0.623, 0.028};
+    xt::xarray<Scalar> grad = eggholderFunc.gradient(x).value();
+    REQUIRE_THAT(grad(0), Catch::Matchers::WithinAbs(-1.87816053485, 1e-4));
+    REQUIRE_THAT(grad(1), Catch::Matchers::WithinAbs(-3.42783757618, 1e-4));
+  }
 
-  // SECTION("Hessian at an arbitrary point") {
-  //   x = {0.623, 0.028};
-  //   xt::xarray<Scalar> hess = eggholderFunc.hessian(x).value();
-  //   REQUIRE_THAT(hess(0, 0), Catch::Matchers::WithinAbs(0.1712307929993,
-  //   1e-4)); REQUIRE_THAT(hess(0, 1),
-  //   Catch::Matchers::WithinAbs(-0.0107824802399, 1e-4)); REQUIRE_THAT(hess(1,
-  //   0), Catch::Matchers::WithinAbs(-0.0107824802399, 1e-4));
-  //   REQUIRE_THAT(hess(1, 1), Catch::Matchers::WithinAbs(0.0514380931854,
-  //   1e-4));
-  // }
+  SECTION("Hessian at an arbitrary point") {
+    x                       = {0.623, 0.028};
+    xt::xarray<Scalar> hess = eggholderFunc.hessian(x).value();
+    REQUIRE_THAT(hess(0, 0), Catch::Matchers::WithinAbs(0.1712307929993, 1e-4));
+    REQUIRE_THAT(
+        hess(0, 1), Catch::Matchers::WithinAbs(-0.0107824802399, 1e-4));
+    REQUIRE_THAT(
+        hess(1, 0), Catch::Matchers::WithinAbs(-0.0107824802399, 1e-4));
+    REQUIRE_THAT(hess(1, 1), Catch::Matchers::WithinAbs(0.0514380931854, 1e-4));
+  }
 }
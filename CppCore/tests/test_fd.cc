@@ -0,0 +1,132 @@
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include "xtsci/func/trial/D2/mullerbrown.hpp"
+#include "xtsci/func/trial/D2/rosenbrock.hpp"
+#include <catch2/catch_all.hpp>
+
+using Scalar = double;
+using xts::func::FDOptions;
+using xts::func::FDStencil;
+
+// Rosenbrock without any derivatives, so everything comes from the fallback
+class ValueOnlyRosenbrock : public xts::func::ObjectiveFunction<Scalar> {
+public:
+  explicit ValueOnlyRosenbrock(
+      const xt::xtensor<bool, 1> &isFixed = xt::zeros<bool>({2}))
+      : xts::func::ObjectiveFunction<Scalar>(2, isFixed) {}
+
+private:
+  Scalar compute(const xt::xarray<Scalar> &x) const override {
+    return xts::func::trial::D2::Rosenbrock<Scalar>::value_kernel(x(0), x(1));
+  }
+};
+
+// MullerBrown with its analytic gradient but without a Hessian
+class GradientOnlyMullerBrown : public xts::func::ObjectiveFunction<Scalar> {
+  using Kernel = xts::func::trial::D2::MullerBrown<Scalar>;
+
+public:
+  GradientOnlyMullerBrown() : xts::func::ObjectiveFunction<Scalar>(2) {
+    this->minima = Kernel().minima;
+  }
+
+private:
+  Scalar compute(const xt::xarray<Scalar> &x) const override {
+    return Kernel::value_kernel(x(0), x(1));
+  }
+
+  std::optional<xt::xarray<Scalar>>
+  compute_gradient(const xt::xarray<Scalar> &x) const override {
+    auto [df_dx, df_dy] = Kernel::gradient_kernel(x(0), x(1));
+    return xt::xarray<Scalar>{df_dx, df_dy};
+  }
+};
+
+TEST_CASE("Finite difference gradients", "[FiniteDiff]") {
+  ValueOnlyRosenbrock func;
+  xts::func::trial::D2::Rosenbrock<Scalar> rosen;
+  xt::xarray<Scalar> x = {-0.3, 0.7};
+
+  SECTION("Off by default") {
+    REQUIRE_FALSE(func.gradient(x).has_value());
+    REQUIRE_FALSE(func.hessian(x).has_value());
+  }
+
+  SECTION("Stencils converge to the analytic gradient") {
+    const auto ref = rosen.gradient(x).value();
+    for (auto [stencil, tol] :
+         {std::pair{FDStencil::forward, 1e-5},
+          std::pair{FDStencil::central, 1e-7},
+          std::pair{FDStencil::five_point, 1e-9}}) {
+      FDOptions<Scalar> opts;
+      opts.stencil = stencil;
+      func.enable_finite_differences(opts);
+      auto grad = func.gradient(x).value();
+      REQUIRE_THAT(grad(0), Catch::Matchers::WithinAbs(ref(0), tol));
+      REQUIRE_THAT(grad(1), Catch::Matchers::WithinAbs(ref(1), tol));
+    }
+  }
+
+  SECTION("Batches fall back as well") {
+    func.enable_finite_differences();
+    xt::xtensor<Scalar, 2> pts = {{0.0, 0.0}, {-0.3, 0.7}, {1.2, 1.0}};
+    auto grads                 = func.gradient_batch(pts).value();
+    auto refs                  = rosen.gradient_batch(pts).value();
+    REQUIRE(xt::allclose(grads, refs, 1e-6, 1e-6));
+  }
+
+  SECTION("Fixed coordinates are not displaced") {
+    ValueOnlyRosenbrock pinned(xt::xtensor<bool, 1>{false, true});
+    pinned.enable_finite_differences();
+    const auto before = pinned.evaluation_counts();
+    auto grad         = pinned.gradient(x).value();
+    REQUIRE(grad(1) == 0.0);
+    const Scalar ref = rosen.gradient(x).value()(0);
+    REQUIRE_THAT(grad(0), Catch::Matchers::WithinAbs(ref, 1e-7));
+    // One miss plus two central displacements of the free coordinate
+    REQUIRE(pinned.evaluation_counts_since(before).unique_func_grad_hess == 3);
+  }
+}
+
+TEST_CASE("Finite difference Hessians", "[FiniteDiff]") {
+  xts::func::trial::D2::Rosenbrock<Scalar> rosen;
+  xt::xarray<Scalar> x = {-0.3, 0.7};
+
+  SECTION("From finite difference gradients") {
+    ValueOnlyRosenbrock func;
+    FDOptions<Scalar> opts;
+    opts.stencil = FDStencil::five_point;
+    func.enable_finite_differences(opts);
+    auto hess = func.hessian(x).value();
+    REQUIRE(xt::allclose(hess, rosen.hessian(x).value(), 1e-5, 1e-4));
+  }
+
+  SECTION("From analytic gradients, threaded") {
+    GradientOnlyMullerBrown mullerbrown;
+    REQUIRE_FALSE(mullerbrown.hessian(x).has_value());
+    FDOptions<Scalar> serial;
+    serial.n_threads = 1;
+    mullerbrown.enable_finite_differences(serial);
+    xt::xarray<Scalar> minimum = xt::row(mullerbrown.minima, 0);
+    auto hess_serial           = mullerbrown.hessian(minimum).value();
+
+    FDOptions<Scalar> threaded;
+    threaded.n_threads = 4;
+    mullerbrown.enable_finite_differences(threaded);
+    auto hess = mullerbrown.hessian(minimum).value();
+    REQUIRE(hess == hess_serial);
+    REQUIRE(hess(0, 1) == hess(1, 0));
+    xts::func::trial::D2::MullerBrown<Scalar> reference;
+    REQUIRE(xt::allclose(hess, reference.hessian(minimum).value(), 1e-6, 1e-4));
+  }
+
+  SECTION("Fixed rows and columns are zero") {
+    ValueOnlyRosenbrock pinned(xt::xtensor<bool, 1>{true, false});
+    pinned.enable_finite_differences();
+    auto hess = pinned.hessian(x).value();
+    REQUIRE(hess(0, 0) == 0.0);
+    REQUIRE(hess(0, 1) == 0.0);
+    REQUIRE(hess(1, 0) == 0.0);
+    REQUIRE_THAT(hess(1, 1), Catch::Matchers::WithinAbs(200.0, 1e-3));
+  }
+}
@@ -0,0 +1,55 @@
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include "xtsci/func/trial/D2/branin.hpp"
+#include "xtsci/func/trial/D2/eggholder.hpp"
+#include "xtsci/func/trial/D2/fixed2d.hpp"
+#include "xtsci/func/trial/D2/mullerbrown.hpp"
+#include "xtsci/func/trial/D2/rosenbrock.hpp"
+#include <catch2/catch_all.hpp>
+
+using xts::func::trial::D2::Fixed2D;
+
+TEST_CASE("Fixed dimension trial functions", "[FixedDim]") {
+  using Scalar = double;
+
+  SECTION("Agrees with the dynamic interface") {
+    Fixed2D<xts::func::trial::D2::Branin, Scalar> branin;
+    xts::func::trial::D2::Branin<Scalar> dyn_branin;
+    using Point              = decltype(branin)::point_type;
+    Point x                  = {1.0, 2.0};
+    xt::xarray<Scalar> dyn_x = {1.0, 2.0};
+
+    REQUIRE_THAT(
+        branin(x), Catch::Matchers::WithinAbs(dyn_branin(dyn_x), 1e-12));
+    REQUIRE(xt::allclose(*branin.gradient(x), *dyn_branin.gradient(dyn_x)));
+    REQUIRE(xt::allclose(*branin.hessian(x), *dyn_branin.hessian(dyn_x)));
+    REQUIRE(branin.minima == dyn_branin.minima);
+  }
+
+  SECTION("Derivatives follow the kernels") {
+    Fixed2D<xts::func::trial::D2::Eggholder, Scalar> eggholder;
+    Fixed2D<xts::func::trial::D2::MullerBrown, Scalar> mullerbrown;
+    xts::func::trial::D2::MullerBrown<Scalar> dyn_mullerbrown;
+    static_assert(decltype(eggholder)::has_gradient);
+    static_assert(decltype(mullerbrown)::has_hessian);
+    REQUIRE(eggholder.hessian({0.0, 0.0}).has_value());
+    xt::xarray<Scalar> dyn_x = {0.1, 0.4};
+    REQUIRE(xt::allclose(
+        *mullerbrown.hessian({0.1, 0.4}), *dyn_mullerbrown.hessian(dyn_x)));
+  }
+
+  SECTION("Fixed degrees of freedom and counters") {
+    Fixed2D<xts::func::trial::D2::Rosenbrock, Scalar> rosen({false, true});
+    auto [fval, grad] = rosen.value_and_gradient({1.0, 2.0}, true);
+    REQUIRE_THAT(fval, Catch::Matchers::WithinAbs(100.0, 1e-12));
+    REQUIRE((*grad)(1) == 0.0);
+    REQUIRE((*rosen.hessian({1.0, 2.0}, true))(0, 1) == 0.0);
+    REQUIRE(rosen.evaluation_counts().function_evals == 1);
+    REQUIRE(rosen.evaluation_counts().hessian_evals == 1);
+  }
+
+  SECTION("Single precision") {
+    Fixed2D<xts::func::trial::D2::Rosenbrock, float> rosen;
+    REQUIRE(rosen({1.0f, 1.0f}) == 0.0f);
+  }
+}
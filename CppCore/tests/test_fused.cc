@@ -0,0 +1,84 @@
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include "xtsci/func/trial/D2/branin.hpp"
+#include "xtsci/func/trial/D2/eggholder.hpp"
+#include "xtsci/func/trial/D2/himmelblau.hpp"
+#include "xtsci/func/trial/D2/mullerbrown.hpp"
+#include "xtsci/func/trial/D2/rosenbrock.hpp"
+#include <catch2/catch_all.hpp>
+
+using Scalar = double;
+
+// Rosenbrock which counts the calls to compute
+class CountingRosenbrock : public xts::func::ObjectiveFunction<Scalar> {
+  using Kernel = xts::func::trial::D2::Rosenbrock<Scalar>;
+
+public:
+  CountingRosenbrock() : xts::func::ObjectiveFunction<Scalar>(2) {}
+  mutable size_t n_values = 0;
+
+private:
+  Scalar compute(const xt::xarray<Scalar> &x) const override {
+    ++n_values;
+    return Kernel::value_kernel(x(0), x(1));
+  }
+
+  std::optional<xt::xarray<Scalar>>
+  compute_gradient(const xt::xarray<Scalar> &x) const override {
+    auto [df_dx, df_dy] = Kernel::gradient_kernel(x(0), x(1));
+    return xt::xarray<Scalar>{df_dx, df_dy};
+  }
+};
+
+template <class Func> void check_fused_matches(const Func &func) {
+  xt::xarray<Scalar> x = {1.623, 0.38};
+  auto [fval, grad]    = func.value_and_gradient(x);
+  REQUIRE_THAT(fval, Catch::Matchers::WithinAbs(func(x), 1e-10));
+  auto ref_grad = func.gradient(x);
+  REQUIRE(grad.has_value() == ref_grad.has_value());
+  if (grad) {
+    REQUIRE(xt::allclose(*grad, *ref_grad));
+  }
+}
+
+TEST_CASE("Fused value and gradient matches separate calls", "[Fused]") {
+  SECTION("Rosenbrock") {
+    check_fused_matches(xts::func::trial::D2::Rosenbrock<Scalar>{});
+  }
+  SECTION("Himmelblau") {
+    check_fused_matches(xts::func::trial::D2::Himmelblau<Scalar>{});
+  }
+  SECTION("Branin") {
+    check_fused_matches(xts::func::trial::D2::Branin<Scalar>{});
+  }
+  SECTION("MullerBrown") {
+    check_fused_matches(xts::func::trial::D2::MullerBrown<Scalar>{});
+  }
+  SECTION("Eggholder") {
+    check_fused_matches(xts::func::trial::D2::Eggholder<Scalar>{});
+  }
+}
+
+TEST_CASE("Fused value, gradient and Hessian", "[Fused]") {
+  xt::xtensor<bool, 1> fixedMask = {false, true};
+  xts::func::trial::D2::Rosenbrock<Scalar> rosen(fixedMask);
+  xt::xarray<Scalar> x = {1.0, 1.0};
+
+  auto [fval, grad, hess] = rosen.value_gradient_hessian(x, true);
+  REQUIRE_THAT(fval, Catch::Matchers::WithinAbs(0.0, 1e-10));
+  REQUIRE(xt::allclose(*grad, *rosen.gradient(x, true)));
+  REQUIRE(xt::allclose(*hess, *rosen.hessian(x, true)));
+  // Everything after the fused call is served from the cache
+  REQUIRE(rosen.evaluation_counts().unique_func_grad_hess == 1);
+}
+
+TEST_CASE("Gradients alone do not compute values", "[Fused]") {
+  CountingRosenbrock rosen;
+  xt::xarray<Scalar> x = {1.623, 0.38};
+  REQUIRE(rosen.gradient(x).has_value());
+  REQUIRE(rosen.n_values == 0);
+  // Nothing was fused, so the value is computed on its own
+  rosen(x);
+  REQUIRE(rosen.n_values == 1);
+  REQUIRE(rosen.evaluation_counts().unique_func_grad_hess == 2);
+}
@@ -0,0 +1,152 @@
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include <filesystem>
+#include <string>
+
+#include "xtensor/xnpy.hpp"
+#include "xtsci/func/grid_scan.hpp"
+#include "xtsci/func/plot_aid.hpp"
+#include "xtsci/func/trial/D2/eggholder.hpp"
+#include "xtsci/func/trial/D2/mullerbrown.hpp"
+#include <catch2/catch_all.hpp>
+
+// Scratch files stay out of the working directory, the source root for meson
+static std::string temp_file(const std::string &name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+TEST_CASE("Threaded grid evaluation", "[Grid]") {
+  using Scalar = double;
+  xts::func::trial::D2::MullerBrown<Scalar> mullerbrown;
+  std::array<Scalar, 3> axOne = {-1.5, 1.2, 37};
+  std::array<Scalar, 3> axTwo = {-0.2, 2.0, 23};
+
+  SECTION("Layout matches pointwise evaluation") {
+    auto z_val  = xts::func::eval_on_grid2D(axOne, axTwo, mullerbrown, 4, 5);
+    auto x_line = xt::linspace<Scalar>(axOne[0], axOne[1], 37);
+    auto y_line = xt::linspace<Scalar>(axTwo[0], axTwo[1], 23);
+    REQUIRE(z_val.shape(0) == 37);
+    REQUIRE(z_val.shape(1) == 23);
+    for (size_t idx = 0; idx < 37; idx += 6) {
+      for (size_t jdx = 0; jdx < 23; jdx += 4) {
+        REQUIRE_THAT(
+            z_val(idx, jdx), Catch::Matchers::WithinAbs(
+                                 mullerbrown(x_line(idx), y_line(jdx)), 1e-10));
+      }
+    }
+  }
+
+  SECTION("Thread count does not change the result") {
+    auto serial   = xts::func::eval_on_grid2D(axOne, axTwo, mullerbrown, 1);
+    auto threaded = xts::func::eval_on_grid2D(axOne, axTwo, mullerbrown, 8, 3);
+    REQUIRE(serial == threaded);
+  }
+
+  SECTION("Matches the std::function variant") {
+    xts::func::trial::D2::Eggholder<Scalar> eggholder;
+    std::function<Scalar(Scalar, Scalar)> efunc
+        = [&eggholder](Scalar x_val, Scalar y_val) {
+            return eggholder(x_val, y_val);
+          };
+    xt::xarray<Scalar> reference
+        = xts::func::eval_on_grid2D<Scalar>(axOne, axTwo, efunc);
+    xt::xarray<Scalar> tiled
+        = xts::func::eval_on_grid2D(axOne, axTwo, eggholder, 3);
+    REQUIRE(xt::allclose(reference, tiled));
+  }
+
+  SECTION("Streamed npz matches the in-memory grid") {
+    auto z_val       = xts::func::eval_on_grid2D(axOne, axTwo, mullerbrown, 2);
+    const auto fname = temp_file("xtsci_stream_mb.npz");
+    xts::func::npz_on_grid2D_stream(
+        axOne, axTwo, mullerbrown, fname, false, 2, 7);
+    auto npz_map = xt::load_npz(fname);
+    auto z_read  = npz_map["z"].cast<Scalar>();
+    auto x_read  = npz_map["x"].cast<Scalar>();
+    auto y_read  = npz_map["y"].cast<Scalar>();
+    REQUIRE(z_read == z_val);
+    REQUIRE(x_read.shape(0) == 37);
+    REQUIRE(y_read.shape(1) == 23);
+    REQUIRE(x_read(5, 3) == xt::linspace<Scalar>(axOne[0], axOne[1], 37)(5));
+    REQUIRE(y_read(5, 3) == xt::linspace<Scalar>(axTwo[0], axTwo[1], 23)(3));
+  }
+
+  SECTION("Streamed npz with only the axes") {
+    const auto fname = temp_file("xtsci_stream_axes.npz");
+    xts::func::npz_on_grid2D_stream(
+        axOne, axTwo, mullerbrown, fname, true, 2, 7);
+    auto npz_map = xt::load_npz(fname);
+    REQUIRE(npz_map["x"].cast<Scalar>().dimension() == 1);
+    REQUIRE(npz_map["y"].cast<Scalar>().size() == 23);
+  }
+
+  SECTION("Streamed npy") {
+    auto z_val       = xts::func::eval_on_grid2D(axOne, axTwo, mullerbrown, 2);
+    const auto fname = temp_file("xtsci_stream_mb.npy");
+    xts::func::npy_on_grid2D_stream(axOne, axTwo, mullerbrown, fname, 2, 5);
+    xt::xarray<Scalar> z_read = xt::load_npy<Scalar>(fname);
+    REQUIRE(z_read == z_val);
+  }
+}
+
+// Weighted sum of squares in any dimension, f(x) = sum_i (i + 1) x_i^2
+class WeightedSquares : public xts::func::ObjectiveFunction<double> {
+public:
+  explicit WeightedSquares(size_t dims)
+      : xts::func::ObjectiveFunction<double>(dims) {}
+
+private:
+  double compute(const xt::xarray<double> &x) const override {
+    double result = 0;
+    for (size_t idx = 0; idx < x.size(); ++idx) {
+      result += static_cast<double>(idx + 1) * x(idx) * x(idx);
+    }
+    return result;
+  }
+};
+
+TEST_CASE("N-dimensional grid scans", "[GridND]") {
+  using Scalar = double;
+  WeightedSquares func(6);
+  xt::xtensor<Scalar, 1> base = {1.0, 1.0, 1.0, 1.0, 1.0, 1.0};
+  std::vector<xts::func::AxisSpec<Scalar>> axes
+      = {{1, -1.0, 1.0, 5}, {4, 0.0, 2.0, 3}, {5, -2.0, 2.0, 7}};
+
+  SECTION("Values and layout") {
+    auto z_val = xts::func::eval_on_gridND(func, base, axes, 3, 4);
+    REQUIRE(z_val.dimension() == 3);
+    REQUIRE(z_val.shape(0) == 5);
+    REQUIRE(z_val.shape(2) == 7);
+    // Pinned coordinates contribute 1 + 3 + 4 = 8
+    xt::xarray<Scalar> point = base;
+    point(1)                 = 0.5;
+    point(4)                 = 2.0;
+    point(5)                 = -4.0 / 3.0;
+    REQUIRE_THAT(
+        z_val(3, 2, 1), Catch::Matchers::WithinAbs(func(point), 1e-12));
+    REQUIRE_THAT(
+        z_val(0, 0, 0), Catch::Matchers::WithinAbs(8 + 2 + 0 + 6 * 4, 1e-12));
+  }
+
+  SECTION("Chunking and threads do not change the result") {
+    auto serial   = xts::func::eval_on_gridND(func, base, axes, 1, 1000);
+    auto threaded = xts::func::eval_on_gridND(func, base, axes, 4, 3);
+    REQUIRE(serial == threaded);
+  }
+
+  SECTION("Streamed to npz") {
+    auto z_val       = xts::func::eval_on_gridND(func, base, axes, 2, 8);
+    const auto fname = temp_file("xtsci_scan.npz");
+    xts::func::npz_on_gridND_stream(func, base, axes, fname, 2, 8);
+    auto npz_map = xt::load_npz(fname);
+    REQUIRE(npz_map["z"].cast<Scalar>() == z_val);
+    REQUIRE(npz_map["axis_2"].cast<Scalar>().size() == 7);
+  }
+
+  SECTION("Invalid axes") {
+    std::vector<xts::func::AxisSpec<Scalar>> bad = {{6, 0.0, 1.0, 2}};
+    REQUIRE_THROWS(xts::func::eval_on_gridND(func, base, bad));
+    bad = {{1, 0.0, 1.0, 2}, {1, 0.0, 1.0, 2}};
+    REQUIRE_THROWS(xts::func::eval_on_gridND(func, base, bad));
+  }
+}
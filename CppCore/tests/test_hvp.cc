@@ -0,0 +1,131 @@
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include "xtsci/func/trial/D2/rosenbrock.hpp"
+#include <catch2/catch_all.hpp>
+
+using Scalar = double;
+using xts::func::FDOptions;
+using xts::func::FDStencil;
+using Rosenbrock = xts::func::trial::D2::Rosenbrock<Scalar>;
+
+// Rosenbrock with its analytic gradient but without a Hessian, so products
+// come from gradient differences
+class GradientOnlyRosenbrock : public xts::func::ObjectiveFunction<Scalar> {
+public:
+  explicit GradientOnlyRosenbrock(
+      const xt::xtensor<bool, 1> &isFixed = xt::zeros<bool>({2}))
+      : xts::func::ObjectiveFunction<Scalar>(2, isFixed) {}
+
+private:
+  Scalar compute(const xt::xarray<Scalar> &x) const override {
+    return Rosenbrock::value_kernel(x(0), x(1));
+  }
+
+  std::optional<xt::xarray<Scalar>>
+  compute_gradient(const xt::xarray<Scalar> &x) const override {
+    auto [df_dx, df_dy] = Rosenbrock::gradient_kernel(x(0), x(1));
+    return xt::xarray<Scalar>{df_dx, df_dy};
+  }
+};
+
+class ValueOnlyRosenbrock : public xts::func::ObjectiveFunction<Scalar> {
+public:
+  ValueOnlyRosenbrock() : xts::func::ObjectiveFunction<Scalar>(2) {}
+
+private:
+  Scalar compute(const xt::xarray<Scalar> &x) const override {
+    return Rosenbrock::value_kernel(x(0), x(1));
+  }
+};
+
+TEST_CASE("Hessian vector products", "[HessianProduct]") {
+  Rosenbrock rosen;
+  xt::xarray<Scalar> x         = {-0.3, 0.7};
+  xt::xarray<Scalar> v         = {0.4, -1.1};
+  const auto hess              = rosen.hessian(x).value();
+  const xt::xarray<Scalar> ref = xt::linalg::dot(hess, v);
+
+  SECTION("Analytic Hessians are multiplied out") {
+    const auto before = rosen.evaluation_counts();
+    auto hv           = rosen.hessian_vector_product(x, v).value();
+    REQUIRE(xt::allclose(hv, ref, 1e-14, 1e-12));
+    REQUIRE(rosen.evaluation_counts_since(before).unique_func_grad_hess == 1);
+  }
+
+  SECTION("Gradient differences reuse the cached gradient") {
+    GradientOnlyRosenbrock func;
+    REQUIRE_FALSE(func.hessian(x).has_value());
+    func.gradient(x);
+    const auto before = func.evaluation_counts();
+    auto hv           = func.hessian_vector_product(x, v).value();
+    REQUIRE(xt::allclose(hv, ref, 1e-5, 1e-4));
+    // Only the displaced gradient is new
+    const auto counts = func.evaluation_counts_since(before);
+    REQUIRE(counts.unique_func_grad_hess == 1);
+    REQUIRE(counts.cache_hits == 1);
+  }
+
+  SECTION("Stencils follow the finite difference options") {
+    GradientOnlyRosenbrock func;
+    FDOptions<Scalar> opts;
+    opts.stencil = FDStencil::central;
+    func.enable_finite_differences(opts);
+    auto hv = func.hessian_vector_product(x, v).value();
+    REQUIRE(xt::allclose(hv, ref, 1e-8, 1e-7));
+  }
+
+  SECTION("Without any gradient there is no product") {
+    ValueOnlyRosenbrock func;
+    REQUIRE_FALSE(func.hessian_vector_product(x, v).has_value());
+    func.enable_finite_differences();
+    auto hv = func.hessian_vector_product(x, v).value();
+    REQUIRE(xt::allclose(hv, ref, 1e-4, 1e-3));
+  }
+
+  SECTION("Fixed coordinates are projected out") {
+    GradientOnlyRosenbrock pinned(xt::xtensor<bool, 1>{true, false});
+    auto hv = pinned.hessian_vector_product(x, v, true).value();
+    REQUIRE(hv(0) == 0.0);
+    // P H P v only sees the free block
+    REQUIRE_THAT(hv(1), Catch::Matchers::WithinRel(hess(1, 1) * v(1), 1e-6));
+    auto hv_free = pinned.hessian_vector_product(x, v).value();
+    REQUIRE_THAT(hv_free(1), Catch::Matchers::WithinRel(ref(1), 1e-6));
+  }
+
+  SECTION("Directions must match the point") {
+    xt::xarray<Scalar> bad = {1.0, 2.0, 3.0};
+    REQUIRE_THROWS_AS(
+        rosen.hessian_vector_product(x, bad), std::invalid_argument);
+  }
+}
+
+TEST_CASE("Hessian matrix products", "[HessianProduct]") {
+  Rosenbrock rosen;
+  xt::xarray<Scalar> x        = {1.2, 1.0};
+  xt::xtensor<Scalar, 2> dirs = {{1.0, 0.0, 0.3, 0.0}, {0.0, 1.0, -2.0, 0.0}};
+  const xt::xtensor<Scalar, 2> ref
+      = xt::linalg::dot(rosen.hessian(x).value(), dirs);
+
+  SECTION("Analytic") {
+    auto prod = rosen.hessian_matrix_product(x, dirs).value();
+    REQUIRE(xt::allclose(prod, ref, 1e-14, 1e-12));
+  }
+
+  SECTION("Columns are threaded") {
+    GradientOnlyRosenbrock func;
+    FDOptions<Scalar> serial;
+    serial.n_threads = 1;
+    func.enable_finite_differences(serial);
+    auto prod_serial = func.hessian_matrix_product(x, dirs).value();
+
+    FDOptions<Scalar> threaded;
+    threaded.n_threads = 4;
+    func.enable_finite_differences(threaded);
+    auto prod = func.hessian_matrix_product(x, dirs).value();
+    REQUIRE(prod == prod_serial);
+    REQUIRE(xt::allclose(prod, ref, 1e-7, 1e-6));
+    // Zero directions are skipped
+    REQUIRE(prod(0, 3) == 0.0);
+    REQUIRE(prod(1, 3) == 0.0);
+  }
+}
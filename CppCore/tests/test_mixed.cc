@@ -0,0 +1,53 @@
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include "xtsci/func/mixed.hpp"
+#include "xtsci/func/plot_aid.hpp"
+#include "xtsci/func/trial/D2/mullerbrown.hpp"
+#include <catch2/catch_all.hpp>
+
+using MullerBrown64 = xts::func::trial::D2::MullerBrown<double>;
+
+TEST_CASE("Float storage over double evaluation", "[Mixed]") {
+  auto inner = std::make_shared<MullerBrown64>();
+  xts::func::MixedPrecision<float> mixed(inner);
+  const xt::xtensor<float, 2> pts = {
+      {-0.558f, 1.442f}, {0.623f, 0.028f}, {-0.05f, 0.467f}, {-0.822f, 0.624f}};
+  const xt::xtensor<double, 2> wide = xt::cast<double>(pts);
+
+  SECTION("Values are the narrowed double results") {
+    const auto vals     = mixed.evaluate_batch(pts);
+    const auto expected = inner->evaluate_batch(wide);
+    for (size_t idx = 0; idx < pts.shape(0); ++idx) {
+      REQUIRE(vals(idx) == static_cast<float>(expected(idx)));
+    }
+    REQUIRE(mixed.minima.shape() == inner->minima.shape());
+  }
+
+  SECTION("Derivatives are narrowed") {
+    const auto [vals, grads] = mixed.value_and_gradient_batch(pts);
+    REQUIRE(grads.has_value());
+    const auto expected = inner->gradient_batch(wide).value();
+    REQUIRE(xt::allclose(*grads, xt::cast<float>(expected)));
+
+    xt::xarray<float> point = xt::row(pts, 2);
+    const auto hess         = mixed.hessian(point);
+    REQUIRE(hess.has_value());
+    const auto expected_hess = inner->hessian(xt::cast<double>(point)).value();
+    REQUIRE(xt::allclose(*hess, xt::cast<float>(expected_hess)));
+  }
+
+  SECTION("Float grids") {
+    const std::array<float, 3> x_axis = {-1.5f, 1.2f, 25};
+    const std::array<float, 3> y_axis = {-0.2f, 2.0f, 25};
+    const auto grid = xts::func::eval_on_grid2D<float>(
+        x_axis, y_axis, [&](float x_val, float y_val) {
+          return mixed(x_val, y_val);
+        });
+    const auto reference = xts::func::eval_on_grid2D<double>(
+        {-1.5, 1.2, 25}, {-0.2, 2.0, 25}, [&](double x_val, double y_val) {
+          return (*inner)(x_val, y_val);
+        });
+    REQUIRE(grid.shape() == reference.shape());
+    REQUIRE(xt::allclose(grid, xt::cast<float>(reference), 1e-4, 1e-3));
+  }
+}
@@ -0,0 +1,98 @@
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include "xtsci/func/path.hpp"
+#include "xtsci/func/trial/D2/mullerbrown.hpp"
+#include <catch2/catch_all.hpp>
+
+using Scalar = double;
+
+// Bowed chain between the two lower MullerBrown minima
+xt::xtensor<Scalar, 2> bowed_chain(size_t n_images) {
+  const xt::xtensor<Scalar, 1> start = {-0.558, 1.442};
+  const xt::xtensor<Scalar, 1> end   = {0.623, 0.028};
+  xt::xtensor<Scalar, 2> images      = xt::empty<Scalar>({n_images, size_t{2}});
+  for (size_t idx = 0; idx < n_images; ++idx) {
+    const Scalar frac = static_cast<Scalar>(idx) / (n_images - 1);
+    const Scalar bow
+        = 0.3 * std::sin(frac * xt::numeric_constants<Scalar>::PI);
+    images(idx, 0) = start(0) + frac * (end(0) - start(0)) + bow;
+    images(idx, 1) = start(1) + frac * (end(1) - start(1)) + bow;
+  }
+  return images;
+}
+
+TEST_CASE("Chain evaluation", "[Path]") {
+  xts::func::trial::D2::MullerBrown<Scalar> mullerbrown;
+  const auto images = bowed_chain(9);
+
+  SECTION("Fixed endpoints") {
+    xts::func::ChainEvaluator<Scalar> chain(mullerbrown);
+    const auto before = mullerbrown.evaluation_counts();
+    const auto path   = chain.evaluate(images);
+    // Seven interior images and the two endpoint energies
+    REQUIRE(mullerbrown.evaluation_counts_since(before).unique_func_grad_hess
+            == 9);
+    for (size_t idx = 0; idx < 9; ++idx) {
+      xt::xarray<Scalar> image = xt::row(images, idx);
+      REQUIRE_THAT(
+          path.energies(idx),
+          Catch::Matchers::WithinAbs(mullerbrown(image), 1e-10));
+    }
+    REQUIRE(xt::all(xt::equal(xt::row(path.gradients, 0), 0.0)));
+    REQUIRE(xt::all(xt::equal(xt::row(path.perpendicular_forces, 8), 0.0)));
+
+    // Matches grad_components image by image
+    for (size_t idx = 1; idx < 8; ++idx) {
+      xt::xarray<Scalar> image   = xt::row(images, idx);
+      xt::xarray<Scalar> tangent = xt::row(path.tangents, idx);
+      REQUIRE_THAT(
+          xt::linalg::norm(tangent), Catch::Matchers::WithinAbs(1.0, 1e-12));
+      auto [parallel, perpendicular]
+          = mullerbrown.grad_components(image, tangent, true);
+      xt::xarray<Scalar> forces = xt::row(path.perpendicular_forces, idx);
+      REQUIRE(xt::allclose(forces, -perpendicular, 1e-10, 1e-10));
+      REQUIRE_THAT(
+          xt::linalg::dot(forces, tangent)(),
+          Catch::Matchers::WithinAbs(0.0, 1e-10));
+    }
+
+    // Unmoved endpoints are not evaluated again
+    const auto again = mullerbrown.evaluation_counts();
+    chain.evaluate(images);
+    REQUIRE(mullerbrown.evaluation_counts_since(again).unique_func_grad_hess
+            == 7);
+  }
+
+  SECTION("Tangents point uphill") {
+    xts::func::ChainEvaluator<Scalar> chain(mullerbrown);
+    const auto path = chain.evaluate(images);
+    for (size_t idx = 1; idx < 8; ++idx) {
+      const bool rising = path.energies(idx + 1) > path.energies(idx)
+                          && path.energies(idx) > path.energies(idx - 1);
+      if (rising) {
+        xt::xarray<Scalar> ahead
+            = xt::row(images, idx + 1) - xt::row(images, idx);
+        ahead /= xt::linalg::norm(ahead);
+        REQUIRE(xt::allclose(xt::row(path.tangents, idx), ahead));
+      }
+    }
+  }
+
+  SECTION("Free endpoints") {
+    xts::func::ChainEvaluator<Scalar> chain(mullerbrown, false);
+    const auto path = chain.evaluate(images);
+    xt::xarray<Scalar> first = xt::row(images, 0);
+    REQUIRE(xt::allclose(
+        xt::row(path.gradients, 0), mullerbrown.gradient(first).value()));
+    xt::xarray<Scalar> towards = xt::row(images, 1) - xt::row(images, 0);
+    towards /= xt::linalg::norm(towards);
+    REQUIRE(xt::allclose(xt::row(path.tangents, 0), towards));
+  }
+
+  SECTION("Too short") {
+    xts::func::ChainEvaluator<Scalar> chain(mullerbrown);
+    REQUIRE_THROWS_AS(
+        chain.evaluate(xt::view(images, xt::range(0, 1), xt::all())),
+        std::invalid_argument);
+  }
+}
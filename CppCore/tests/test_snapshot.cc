@@ -0,0 +1,72 @@
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include <filesystem>
+
+#include "rgpot/CuH2/CuH2Pot.hpp"
+#include "xtsci/pot/snapshot.hpp"
+#include <catch2/catch_all.hpp>
+
+std::string temp_path(const std::string &name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+TEST_CASE("Binary snapshots", "[Snapshot]") {
+  auto [positions, atomTypes, boxMatrix, booltypes]
+      = xts::pot::extract_condat("cuh2.con");
+  const auto snap_fname = temp_path("xtsci_cuh2.snap");
+  xts::pot::con_to_snapshot("cuh2.con", snap_fname);
+
+  SECTION("Mapped arrays match the con file") {
+    const xts::io::Snapshot snap(snap_fname);
+    REQUIRE(snap.n_atoms() == 218);
+    REQUIRE(snap.positions() == positions);
+    REQUIRE(snap.atom_types() == atomTypes);
+    REQUIRE(xt::all(xt::equal(xt::cast<bool>(snap.fixed()), booltypes)));
+    REQUIRE(snap.box_matrix() == boxMatrix);
+    REQUIRE_FALSE(snap.energy().has_value());
+    REQUIRE_FALSE(snap.gradient().has_value());
+  }
+
+  SECTION("Round trip through con") {
+    const auto con_fname = temp_path("xtsci_cuh2_back.con");
+    xts::pot::snapshot_to_con(snap_fname, con_fname);
+    xts::io::ConReader original("cuh2.con");
+    xts::io::ConReader restored(con_fname);
+    xts::io::ConFrame before, after;
+    REQUIRE(original.next(before));
+    REQUIRE(restored.next(after));
+    REQUIRE(after.positions == before.positions);
+    REQUIRE(after.symbols == before.symbols);
+    REQUIRE(after.counts == before.counts);
+    REQUIRE(after.masses == before.masses);
+    REQUIRE(after.is_fixed == before.is_fixed);
+    REQUIRE(after.atom_ids == before.atom_ids);
+    REQUIRE(after.box_lengths == before.box_lengths);
+  }
+
+  SECTION("Potentials from snapshots") {
+    auto cuh2pot      = std::make_shared<rgpot::CuH2Pot>();
+    auto from_con     = xts::pot::mk_xtpot_con("cuh2.con", cuh2pot);
+    auto from_snap    = xts::pot::mk_xtpot_snapshot(snap_fname, cuh2pot);
+    const auto free_x = from_con.get_free(positions);
+    REQUIRE(from_snap(free_x) == from_con(free_x));
+  }
+
+  SECTION("Restarts keep the last evaluation") {
+    xts::io::ConReader reader("cuh2.con");
+    xts::io::ConFrame frame;
+    REQUIRE(reader.next(frame));
+    const xt::xtensor<double, 1> grad = {0.1, -0.2, 0.3, 0.0, 0.5, -0.6};
+    const auto restart                = temp_path("xtsci_restart.snap");
+    xts::io::write_snapshot(
+        restart, frame, xts::pot::frame_atom_types(frame), -697.3, grad);
+    const xts::io::Snapshot snap(restart);
+    REQUIRE(snap.energy() == -697.3);
+    REQUIRE(snap.gradient().value() == grad);
+    REQUIRE(snap.positions() == positions);
+  }
+
+  SECTION("Other files are rejected") {
+    REQUIRE_THROWS_AS(xts::io::Snapshot("cuh2.con"), std::runtime_error);
+  }
+}
@@ -0,0 +1,58 @@
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include "xtsci/func/plot_aid.hpp"
+#include "xtsci/func/static_dispatch.hpp"
+#include "xtsci/func/trial/D2/branin.hpp"
+#include "xtsci/func/trial/D2/eggholder.hpp"
+#include "xtsci/func/trial/D2/himmelblau.hpp"
+#include "xtsci/func/trial/D2/mullerbrown.hpp"
+#include "xtsci/func/trial/D2/rosenbrock.hpp"
+#include <catch2/catch_all.hpp>
+
+namespace D2 = xts::func::trial::D2;
+
+static_assert(xts::func::StaticGradient2D<D2::Rosenbrock<double>>);
+static_assert(xts::func::StaticGradient2D<D2::Himmelblau<float>>);
+static_assert(xts::func::StaticGradient2D<D2::Branin<double>>);
+static_assert(xts::func::StaticGradient2D<D2::MullerBrown<double>>);
+static_assert(xts::func::StaticGradient2D<D2::Eggholder<double>>);
+
+TEST_CASE("Static dispatch agrees with the virtual interface", "[Static]") {
+  using Scalar = double;
+  D2::MullerBrown<Scalar> mullerbrown;
+  xt::xtensor<Scalar, 2> pts = {{0.0, 0.0}, {-0.558, 1.442}, {1.623, 0.38}};
+
+  SECTION("Batches") {
+    using MB   = D2::MullerBrown<Scalar>;
+    auto vals  = xts::func::static_evaluate_batch<MB>(pts);
+    auto grads = xts::func::static_gradient_batch<MB>(pts);
+    REQUIRE(xt::allclose(vals, mullerbrown.evaluate_batch(pts)));
+    REQUIRE(xt::allclose(grads, *mullerbrown.gradient_batch(pts)));
+  }
+
+  SECTION("Grids") {
+    std::array<Scalar, 3> axOne = {-1.5, 1.2, 31};
+    std::array<Scalar, 3> axTwo = {-0.2, 2.0, 17};
+    auto z_static = xts::func::static_eval_on_grid2D<D2::MullerBrown<Scalar>>(
+        axOne, axTwo, 3);
+    auto z_virtual = xts::func::eval_on_grid2D(axOne, axTwo, mullerbrown, 3);
+    REQUIRE(xt::allclose(z_static, z_virtual));
+  }
+
+  SECTION("Line scans") {
+    std::vector<Scalar> alphas = {0.0, 0.25, 1.0};
+    auto phi  = xts::func::static_line_values<D2::Rosenbrock<Scalar>>(
+        {0.0, 0.0}, {1.0, 1.0}, alphas);
+    auto dphi = xts::func::static_line_slopes<D2::Rosenbrock<Scalar>>(
+        {0.0, 0.0}, {1.0, 1.0}, alphas);
+    D2::Rosenbrock<Scalar> rosen;
+    REQUIRE_THAT(
+        phi[1], Catch::Matchers::WithinAbs(rosen(0.25, 0.25), 1e-12));
+    REQUIRE_THAT(phi[2], Catch::Matchers::WithinAbs(0.0, 1e-12));
+    xt::xarray<Scalar> x   = {0.25, 0.25};
+    xt::xarray<Scalar> dir = {1.0, 1.0};
+    REQUIRE_THAT(
+        dphi[1], Catch::Matchers::WithinAbs(
+                     rosen.directional_derivative(x, dir), 1e-12));
+  }
+}
@@ -0,0 +1,106 @@
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include "xtsci/func/parallel.hpp"
+#include "xtsci/func/trace.hpp"
+#include "xtsci/func/trial/D2/mullerbrown.hpp"
+#include <catch2/catch_all.hpp>
+#include <set>
+#include <thread>
+
+namespace trace = xts::func::trace;
+
+size_t count_named(
+    const std::vector<trace::TraceEvent> &events, const char *name) {
+  return std::count_if(events.begin(), events.end(), [&](const auto &event) {
+    return std::string(event.name) == name;
+  });
+}
+
+TEST_CASE("Scoped timers", "[Trace]") {
+  auto &tracer = trace::Tracer::instance();
+  tracer.reset();
+
+  SECTION("Events from every thread are kept") {
+    xts::func::parallel::parallel_for(
+        64, 4, [](size_t, size_t) { trace::ScopedTimer timer("task"); });
+    const auto events = tracer.events();
+    REQUIRE(count_named(events, "task") == 64);
+    REQUIRE(std::is_sorted(
+        events.begin(), events.end(), [](const auto &lhs, const auto &rhs) {
+          return lhs.start_ns < rhs.start_ns;
+        }));
+    const auto hists = tracer.histograms();
+    REQUIRE(hists.at("task").count == 64);
+    REQUIRE(hists.at("task").min_ns <= hists.at("task").quantile_ns(0.5));
+    REQUIRE(hists.at("task").quantile_ns(0.5) <= hists.at("task").max_ns);
+  }
+
+  SECTION("Finished threads hand their buffer on") {
+    for (size_t idx = 0; idx < 32; ++idx) {
+      std::thread([] { trace::ScopedTimer timer("reused"); }).join();
+    }
+    std::set<uint32_t> threads;
+    for (const auto &event : tracer.events()) {
+      if (std::string(event.name) == "reused") {
+        threads.insert(event.thread);
+      }
+    }
+    REQUIRE(count_named(tracer.events(), "reused") == 32);
+    REQUIRE(threads.size() == 1);
+  }
+
+  SECTION("Runtime switch") {
+    tracer.set_enabled(false);
+    {
+      trace::ScopedTimer timer("skipped");
+    }
+    tracer.set_enabled(true);
+    REQUIRE(count_named(tracer.events(), "skipped") == 0);
+  }
+
+  SECTION("Buffers grow past a chunk") {
+    for (size_t idx = 0; idx < 10000; ++idx) {
+      trace::ScopedTimer timer("many");
+    }
+    REQUIRE(count_named(tracer.events(), "many") == 10000);
+  }
+
+  SECTION("Chrome trace export") {
+    {
+      trace::ScopedTimer timer("exported");
+    }
+    const std::string json = tracer.chrome_trace();
+    REQUIRE(json.find("\"traceEvents\"") != std::string::npos);
+    REQUIRE(json.find("\"name\": \"exported\"") != std::string::npos);
+    REQUIRE(json.find("\"ph\": \"X\"") != std::string::npos);
+  }
+
+  SECTION("Names are escaped in the export") {
+    {
+      trace::ScopedTimer timer("say \"hi\"\\\n");
+    }
+    const std::string json = tracer.chrome_trace();
+    REQUIRE(
+        json.find("\"name\": \"say \\\"hi\\\"\\\\\\u000a\"")
+        != std::string::npos);
+  }
+}
+
+TEST_CASE("Instrumented evaluations", "[Trace]") {
+  auto &tracer = trace::Tracer::instance();
+  tracer.reset();
+  xts::func::trial::D2::MullerBrown<double> mullerbrown;
+  const xt::xarray<double> point = {-0.5, 1.5};
+  mullerbrown(point);
+  mullerbrown.gradient(point);
+  mullerbrown.hessian(point);
+  const auto events = tracer.events();
+#ifdef XTSCI_ENABLE_TRACING
+  REQUIRE(count_named(events, "ObjectiveFunction::operator()") == 1);
+  REQUIRE(count_named(events, "ObjectiveFunction::gradient") == 1);
+  REQUIRE(count_named(events, "ObjectiveFunction::hessian") == 1);
+#else
+  // Compiled out
+  REQUIRE(events.empty());
+#endif
+}
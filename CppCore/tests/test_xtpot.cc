@@ -99,3 +99,20 @@ TEST_CASE(
   REQUIRE(
       xt::all(xt::isclose(free_positions, expected_free_positions, TEST_EPS)));
 }
+
+TEST_CASE("Free coordinate sizes are checked", "[XTPot]") {
+  xt::xarray<double> base_pos = {{1.0, 2.0, 3.0}, {4.0, 5.0, 6.0}};
+  xt::xarray<int> atomTypes   = {1, 2};
+  xt::xarray<double> boxMatrix
+      = {{1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, {0.0, 0.0, 1.0}};
+  xt::xarray<bool> fixedMask = {true, false};
+
+  TestXTPot pot(nullptr, base_pos, atomTypes, boxMatrix, fixedMask);
+  xt::xarray<double> too_long = {0.1, 0.2, 0.3, 0.4};
+  REQUIRE_THROWS_AS(pot.test_reconstruct_full(too_long), std::runtime_error);
+
+  // Structured and flat positions gather the same free coordinates
+  auto free_x = pot.get_free(base_pos);
+  REQUIRE(free_x == pot.get_free(xt::flatten(base_pos)));
+  REQUIRE(xt::allclose(pot.test_reconstruct_full(free_x), base_pos));
+}
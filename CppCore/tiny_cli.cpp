@@ -1,173 +1,415 @@
 // MIT License
 // Copyright 2023--present Rohit Goswami <HaoZeke>
 #include <fmt/format.h>
-#include <fmt/ostream.h>
 
-#include <cmath>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
 #include <cstdlib>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
-#include <iostream>
-#include <random>
-
-#include "xtensor-fmt/misc.hpp"
-#include "xtensor/xarray.hpp"
-#include "xtensor/xlayout.hpp"
-#include "xtensor/xshape.hpp"
-#include "xtensor/xvectorize.hpp"
+#include "xtensor/xnpy.hpp"
+#include "xtensor/xtensor.hpp"
+#include "xtensor/xview.hpp"
 
+#include "xtsci/func/base.hpp"
+#include "xtsci/func/parallel.hpp"
 #include "xtsci/func/plot_aid.hpp"
 #include "xtsci/func/trial/D2/branin.hpp"
 #include "xtsci/func/trial/D2/eggholder.hpp"
 #include "xtsci/func/trial/D2/himmelblau.hpp"
 #include "xtsci/func/trial/D2/mullerbrown.hpp"
 #include "xtsci/func/trial/D2/rosenbrock.hpp"
+#include "xtsci/io/npy.hpp"
 
 #include "rgpot/CuH2/CuH2Pot.hpp"
-#include "rgpot/CuH2/cuh2Utils.hpp"
 #include "xtsci/pot/base.hpp"
+#include "xtsci/pot/snapshot.hpp"
 
-#include "readCon/include/BaseTypes.hpp"
-#include "readCon/include/ReadCon.hpp"
-#include "readCon/include/adapters/xtensor.hpp"
+// Batch evaluation driver. A function from the registry below is evaluated at
+// every row of an (n_points, dims) .npy file, or on a 2-D grid, and f, \nabla
+// f and \nabla^2 f are written to .npz (or one .npy per quantity). Trial
+// functions are split into blocks of rows shared out over the threads, XTPot
+// hands its whole batch, and the difference probes of each Hessian, to one
+// potential per thread.
 
-int main(int argc, char *argv[]) {
-  // Eat warnings, also safer
-  static_cast<void>(argc);
-  static_cast<void>(argv);
-  // xts::func::trial::D2::Rosenbrock<double> rosen;
-  // xts::func::trial::D2::Himmelblau<double> himmelblau;
-  // // xts::func::trial::D2::QuadraticFunction<double> quadratic;
-  // xts::func::trial::D2::Eggholder<double> eggholder;
-  // xts::func::trial::D2::MullerBrown<double> mullerbrown;
-  // xts::func::trial::D2::Branin<double> branin;
-
-  // clang-format off
-  // Rosenbrock
-  // xt::xarray<double> min1 = xt::row(rosen.minima, 0); // {0, 0}
-  // fmt::print("Rosenbrock Minima: {} with fval {}\n", min1, rosen(min1));
-  // clang-format on
-
-  // Grid test
-  // auto z_mesh = xts::func::eval_on_grid2D<double>({-2, 2, 100}, {-2, 2, 100}
-  // ,rosen); for (auto i : z_mesh) {
-  //   fmt::print("{} ", i);
-  // }
-
-  // clang-format off
-  // Muller Brown
-  // xt::xarray<double> min1 = xt::row(mullerbrown.minima, 0);
-  // {-0.558, 1.441}
-  // xt::xarray<double> min2 = xt::row(mullerbrown.minima, 1);
-  // {0.623, 0.028}
-  // xt::xarray<double> min3 = xt::row(mullerbrown.minima, 2);
-  // {-0.050, 0.466}
-  // fmt::print("Minima: {}, {}, {}\n", min1, min2, min3);
-  // clang-format on
-
-  // clang-format off
-  // Himmelblau
-  // xt::xarray<double> min1 =
-  // xt::row(himmelblau.minima, 0); // {3, 2};
-  // xt::xarray<double> min2 =
-  // xt::row(himmelblau.minima, 1); // {-2.805118, 3.131312};
-  // xt::xarray<double> min3 =
-  // xt::row(himmelblau.minima, 2); // {-3.779310, -3.283186};
-  // xt::xarray<double> min4 =
-  // xt::row(himmelblau.minima, 3); // {3.584428, -1.848126};
-  // fmt::print("Himmelblau Minima:\n{}, {}\n{}, {}\n{},
-  // {}\n{}, {}\n", min1,
-  //            himmelblau(min1), min2, himmelblau(min2),
-  //            min3, himmelblau(min3),
-  //            min4, himmelblau(min4));
-  // clang-format on
-
-  // clang-format off
-  // npz test
-  // xts::func::npz_on_grid2D<double>({-2, 2, 100}, {-2, 2, 100}, rosen,
-  //                                  "rosen.npz");
-  // xts::func::npz_on_grid2D<double>({-5, 5, 400}, {-5, 5, 400}, himmelblau,
-  //                                  "himmelblau.npz");
-  // xts::func::npz_on_grid2D<double>({-1.5, 1.2, 400}, {-0.2, 2.0, 400},
-  //                                  mullerbrown, "mullerbrown.npz");
-  // xts::func::npz_on_grid2D<double>({-512, 612, 400}, {-512, 613, 400},
-  //                                  eggholder, "eggholder.npz");
-  // xts::func::npz_on_grid2D<double>({-5, 18, 400}, {-5, 20, 400}, branin,
-  //                                  "branin.npz");
-  // clang-format on
-  xt::xtensor<bool, 1> fixedMask = {true, false};
-  xts::func::trial::D2::Branin<double> branin_fixed(fixedMask);
-  xt::xarray<double> x = {1.0, 1.0};
+namespace {
 
-  fmt::print(
-      "Branin function at 1, 1 is {} and gradient is {} with mask ({} {})",
-      branin_fixed(x), *branin_fixed.gradient(x, true),
-      branin_fixed.m_isFixed[0], branin_fixed.m_isFixed[1]);
-
-  auto cuh2pot = std::make_shared<rgpot::CuH2Pot>();
-  // xt::xtensor<int, 1> atomTypes{{29, 29, 1, 1}};
-  // xt::xtensor<double, 2> boxMatrix{
-  //     {15, 0, 0},
-  //     {0, 20, 0},
-  //     {0, 0, 30},
-  // };
-
-  // xt::xtensor<double, 2> positions{
-  //     {0.63940268750835, 0.90484742551374, 6.97516498544584}, // Cu
-  //     {3.19652040936288, 0.90417430354811, 6.97547796369474}, // Cu
-  //     {8.98363230369760, 9.94703496017833, 7.83556854923689}, // H
-  //     {7.64080177576300, 9.94703114803832, 7.83556986121272}, // H
-  // };
-
-  // auto objFunc = xts::pot::mk_xtpot_con("cuh2.con", cuh2pot);
-  // std::vector<std::string> fconts
-  //     = yodecon::helpers::file::read_con_file("cuh2.con");
-  // auto frame =
-  // yodecon::create_single_con<yodecon::types::ConFrameVec>(fconts); auto
-  // [positions, atomTypes, boxMatrix, booltypes]
-  //     = xts::pot::extract_condat("cuh2.con");
-  // // // fmt::print("\nPutting in {}\n", fmt::streamed(booltypes));
-  // fmt::print("\nFree {}\n", fmt::streamed(objFunc.get_free(positions)));
-
-  // double energy = objFunc(objFunc.get_free(positions));
-  // auto grad     = objFunc.gradient(objFunc.get_free(positions));
-  // // Reference:
-  // // ❯ eonclient -s "cuh2.con" -p cuh2
-  // // Energy:         -697.3134512906
-  // // (free) Forces:
-  // //  0.00258381 2.71051e-20 0.000809943
-  // // -0.00258381 1.69407e-20 0.000809943
-
-  // auto [hdist, cusdist]
-  //     = rgpot::cuh2::utils::xts::calculateDistances(positions, atomTypes);
-  // fmt::print("HH distance {}\n CuSlab distance {}\n", hdist, cusdist);
-
-  // auto new_positions = rgpot::cuh2::utils::xts::perturb_positions(
-  //     positions, atomTypes, cusdist, hdist + 10);
-  // // fmt::print("New positions:\n{}\n", fmt::streamed(new_positions));
-  // // fmt::print("Old positions:\n{}\n", fmt::streamed(positions));
-
-  // fmt::print("Got gradient {}\n", fmt::streamed(*grad));
-  // fmt::print("Got energy {}\n", energy);
-  // double new_energy = objFunc(
-  //     objFunc.get_free(xt::ravel<xt::layout_type::row_major>(new_positions)));
-  // auto new_grad = objFunc.gradient(
-  //     objFunc.get_free(xt::ravel<xt::layout_type::row_major>(new_positions)));
-  // fmt::print("Got new energy {}\n", new_energy);
-  // fmt::print("Got gradient {}\n", fmt::streamed(*new_grad));
-
-  // // auto energyFunc = [&objFunc, &positions, &atomTypes](
-  // //                       double hh_dist, double cu_slab_dist) -> double {
-  // //   auto perturbed_positions =
-  // //       rgpot::cuh2::utils::xts::perturb_positions(positions, atomTypes,
-  // //       cu_slab_dist, hh_dist);
-  // //   return
-  // //   objFunc(xt::ravel<xt::layout_type::row_major>(perturbed_positions)) -
-  // //          (-697.311695);
-  // // };
-
-  // // xts::func::npz_on_grid2D<double>({0.4, 3.2, 60}, {-0.05, 3.1, 60},
-  // // energyFunc,
-  // //                                  "cuh2_grid.npz");
+using Scalar    = double;
+using Objective = xts::func::ObjectiveFunction<Scalar>;
+using Pot       = xts::pot::XTPot<Scalar>;
+
+constexpr size_t block_rows = 256;
+
+constexpr const char *usage = R"(Usage: tiny_cli FUNCTION [options]
+
+Functions: rosenbrock, himmelblau, mullerbrown, branin, eggholder, xtpot
+
+Points (one of):
+  --points FILE.npy      (n_points, dims) points, for xtpot either free
+                         coordinates or flat (n_points, n_atoms * 3) positions
+  --grid X0,X1,NX,Y0,Y1,NY
+                         NX x NY grid of a 2-D function, z(i, j) = f(x_i, y_j)
+Options:
+  --eval f,grad,hess     Quantities to compute (default f)
+  --out FILE             .npz, or .npy with one file per quantity
+                         (FILE_grad.npy, ...) beyond the first (default out.npz)
+  --threads N            Worker threads, 0 is one per hardware thread (default)
+  --zero-fixed           Zero the derivatives of fixed coordinates
+  --fd                   Finite differences for missing derivatives
+  --con FILE             Structure for xtpot (CuH2 potential)
+  --snapshot FILE        Binary snapshot for xtpot, instead of --con
+)";
+
+struct Options {
+  std::string function;
+  std::string points;
+  std::optional<std::array<std::array<Scalar, 3>, 2>> grid;
+  bool want_grad   = false;
+  bool want_hess   = false;
+  std::string out  = "out.npz";
+  size_t n_threads = 0;
+  bool zero_fixed  = false;
+  bool fd          = false;
+  std::string con;
+  std::string snapshot;
+};
+
+std::vector<std::string> split(const std::string &text, char sep) {
+  std::vector<std::string> parts;
+  size_t start = 0;
+  while (true) {
+    const size_t end = text.find(sep, start);
+    parts.push_back(text.substr(start, end - start));
+    if (end == std::string::npos) {
+      return parts;
+    }
+    start = end + 1;
+  }
+}
+
+Options parse_args(int argc, char *argv[]) {
+  if (argc < 2) {
+    throw std::invalid_argument("No function given.");
+  }
+  Options opts;
+  opts.function = argv[1];
+  auto value    = [&](int &idx) -> std::string {
+    if (idx + 1 >= argc) {
+      throw std::invalid_argument(std::string(argv[idx]) + " needs a value.");
+    }
+    return argv[++idx];
+  };
+  for (int idx = 2; idx < argc; ++idx) {
+    const std::string arg = argv[idx];
+    if (arg == "--points") {
+      opts.points = value(idx);
+    } else if (arg == "--grid") {
+      const auto parts = split(value(idx), ',');
+      if (parts.size() != 6) {
+        throw std::invalid_argument("--grid takes X0,X1,NX,Y0,Y1,NY.");
+      }
+      std::array<std::array<Scalar, 3>, 2> axes{};
+      for (size_t pos = 0; pos < parts.size(); ++pos) {
+        axes[pos / 3][pos % 3] = std::stod(parts[pos]);
+      }
+      opts.grid = axes;
+    } else if (arg == "--eval") {
+      for (const auto &quantity : split(value(idx), ',')) {
+        if (quantity == "grad") {
+          opts.want_grad = true;
+        } else if (quantity == "hess") {
+          opts.want_hess = true;
+        } else if (quantity != "f") {
+          throw std::invalid_argument("Unknown quantity " + quantity);
+        }
+      }
+    } else if (arg == "--out") {
+      opts.out = value(idx);
+    } else if (arg == "--threads") {
+      opts.n_threads = std::stoul(value(idx));
+    } else if (arg == "--zero-fixed") {
+      opts.zero_fixed = true;
+    } else if (arg == "--fd") {
+      opts.fd = true;
+    } else if (arg == "--con") {
+      opts.con = value(idx);
+    } else if (arg == "--snapshot") {
+      opts.snapshot = value(idx);
+    } else {
+      throw std::invalid_argument("Unknown option " + arg);
+    }
+  }
+  if (opts.points.empty() == !opts.grid) {
+    throw std::invalid_argument("Give exactly one of --points and --grid.");
+  }
+  return opts;
+}
+
+template <class Trial> std::shared_ptr<Objective> make_trial(const Options &) {
+  return std::make_shared<Trial>();
+}
+
+std::shared_ptr<Objective> make_xtpot(const Options &opts) {
+  auto cuh2 = std::make_shared<rgpot::CuH2Pot>();
+  std::shared_ptr<Pot> pot;
+  if (!opts.snapshot.empty()) {
+    pot = std::make_shared<Pot>(
+        xts::pot::mk_xtpot_snapshot(opts.snapshot, cuh2));
+  } else if (!opts.con.empty()) {
+    pot = std::make_shared<Pot>(xts::pot::mk_xtpot_con(opts.con, cuh2));
+  } else {
+    throw std::invalid_argument("xtpot needs --con or --snapshot.");
+  }
+  pot->enable_parallel_batches(
+      [] { return std::make_shared<rgpot::CuH2Pot>(); }, opts.n_threads);
+  return pot;
+}
+
+using Factory = std::function<std::shared_ptr<Objective>(const Options &)>;
+
+const std::map<std::string, Factory> &registry() {
+  namespace D2 = xts::func::trial::D2;
+  static const std::map<std::string, Factory> functions = {
+      {"rosenbrock", make_trial<D2::Rosenbrock<Scalar>>},
+      {"himmelblau", make_trial<D2::Himmelblau<Scalar>>},
+      {"mullerbrown", make_trial<D2::MullerBrown<Scalar>>},
+      {"branin", make_trial<D2::Branin<Scalar>>},
+      {"eggholder", make_trial<D2::Eggholder<Scalar>>},
+      {"xtpot", make_xtpot},
+  };
+  return functions;
+}
+
+// Rows of the .npy as points of func, flat positions are reduced to the free
+// coordinates for XTPot
+xt::xtensor<Scalar, 2> load_points(const Options &opts, const Objective &func) {
+  // XTPot points are its free coordinates
+  const auto *pot     = dynamic_cast<const Pot *>(&func);
+  const size_t n_dims = pot != nullptr ? pot->n_free() : func.m_isFixed.size();
 
+  xt::xtensor<Scalar, 2> pts = xt::load_npy<Scalar>(opts.points);
+  if (pot != nullptr && pts.shape(1) == pot->n_atoms() * 3
+      && pts.shape(1) != n_dims) {
+    xt::xtensor<Scalar, 2> free_pts
+        = xt::empty<Scalar>({pts.shape(0), n_dims});
+    for (size_t row = 0; row < pts.shape(0); ++row) {
+      pot->gather_free(&pts(row, 0), &free_pts(row, 0));
+    }
+    return free_pts;
+  }
+  if (pts.shape(1) != n_dims) {
+    throw std::invalid_argument(
+        opts.points + " has " + std::to_string(pts.shape(1))
+        + " columns, the function " + std::to_string(n_dims) + " dimensions.");
+  }
+  return pts;
+}
+
+// Points in the order of eval_on_grid2D, x major
+xt::xtensor<Scalar, 2>
+grid_points(const std::array<std::array<Scalar, 3>, 2> &axes) {
+  const auto x_line = xts::func::detail::grid_axis(axes[0]);
+  const auto y_line = xts::func::detail::grid_axis(axes[1]);
+  xt::xtensor<Scalar, 2> pts
+      = xt::empty<Scalar>({x_line.size() * y_line.size(), size_t{2}});
+  for (size_t idx = 0; idx < x_line.size(); ++idx) {
+    for (size_t jdx = 0; jdx < y_line.size(); ++jdx) {
+      pts(idx * y_line.size() + jdx, 0) = x_line(idx);
+      pts(idx * y_line.size() + jdx, 1) = y_line(jdx);
+    }
+  }
+  return pts;
+}
+
+struct Results {
+  xt::xtensor<Scalar, 1> values;
+  std::optional<xt::xtensor<Scalar, 2>> gradients;
+  std::optional<xt::xtensor<Scalar, 3>> hessians;
+};
+
+Results evaluate(
+    const Options &opts, const Objective &func,
+    const xt::xtensor<Scalar, 2> &pts) {
+  const size_t n_pts  = pts.shape(0);
+  const size_t n_dims = pts.shape(1);
+  Results res;
+  res.values = xt::empty<Scalar>({n_pts});
+  if (opts.want_grad) {
+    res.gradients
+        = xt::xtensor<Scalar, 2>(xt::empty<Scalar>({n_pts, n_dims}));
+  }
+  if (opts.want_hess) {
+    res.hessians = xt::xtensor<Scalar, 3>(
+        xt::empty<Scalar>({n_pts, n_dims, n_dims}));
+  }
+  // XTPot already spreads one batch over its workers. Its Hessians come from
+  // gradient differences, and the probes of each point go to the workers as
+  // one batch, so the rows are not split over threads here as well
+  const bool own_workers = dynamic_cast<const Pot *>(&func) != nullptr;
+  const size_t rows = own_workers ? std::max<size_t>(n_pts, 1) : block_rows;
+  const size_t n_blocks = (n_pts + rows - 1) / rows;
+  xts::func::parallel::parallel_for(
+      n_blocks, own_workers ? 1 : opts.n_threads, [&](size_t, size_t block) {
+        const size_t lo  = block * rows;
+        const size_t hi  = std::min(lo + rows, n_pts);
+        const auto range = xt::range(lo, hi);
+        const xt::xtensor<Scalar, 2> chunk = xt::view(pts, range, xt::all());
+        if (opts.want_grad) {
+          auto [vals, grads]
+              = func.value_and_gradient_batch(chunk, opts.zero_fixed);
+          if (!grads) {
+            throw std::runtime_error(
+                "No gradient for " + opts.function + ", try --fd.");
+          }
+          xt::view(res.values, range)                = vals;
+          xt::view(*res.gradients, range, xt::all()) = *grads;
+        } else {
+          xt::view(res.values, range) = func.evaluate_batch(chunk);
+        }
+        if (!opts.want_hess) {
+          return;
+        }
+        for (size_t row = lo; row < hi; ++row) {
+          const xt::xarray<Scalar> point = xt::row(pts, row);
+          const auto hess                = func.hessian(point, opts.zero_fixed);
+          if (!hess) {
+            throw std::runtime_error(
+                "No Hessian for " + opts.function + ", try --fd.");
+          }
+          xt::view(*res.hessians, row, xt::all(), xt::all()) = *hess;
+        }
+      });
+  return res;
+}
+
+template <typename T>
+std::vector<size_t> grid_shape(const T &arr, size_t nx, size_t ny) {
+  std::vector<size_t> shape{nx, ny};
+  shape.insert(shape.end(), arr.shape().begin() + 1, arr.shape().end());
+  return shape;
+}
+
+// Every computed quantity under its name, reshaped to the grid for --grid
+void write_results(const Options &opts, const Results &res) {
+  struct Entry {
+    std::string name;
+    std::vector<size_t> shape;
+    const Scalar *data;
+  };
+  std::vector<Entry> entries;
+  std::vector<xt::xtensor<Scalar, 1>> axes;
+  if (opts.grid) {
+    axes.push_back(xts::func::detail::grid_axis((*opts.grid)[0]));
+    axes.push_back(xts::func::detail::grid_axis((*opts.grid)[1]));
+    const size_t nx = axes[0].size();
+    const size_t ny = axes[1].size();
+    entries.push_back({"z", {nx, ny}, res.values.data()});
+    entries.push_back({"x", {nx}, axes[0].data()});
+    entries.push_back({"y", {ny}, axes[1].data()});
+    if (res.gradients) {
+      entries.push_back(
+          {"grad", grid_shape(*res.gradients, nx, ny),
+           res.gradients->data()});
+    }
+    if (res.hessians) {
+      entries.push_back(
+          {"hess", grid_shape(*res.hessians, nx, ny), res.hessians->data()});
+    }
+  } else {
+    entries.push_back({"f", {res.values.size()}, res.values.data()});
+    if (res.gradients) {
+      const auto &shape = res.gradients->shape();
+      entries.push_back(
+          {"grad", {shape.begin(), shape.end()}, res.gradients->data()});
+    }
+    if (res.hessians) {
+      const auto &shape = res.hessians->shape();
+      entries.push_back(
+          {"hess", {shape.begin(), shape.end()}, res.hessians->data()});
+    }
+  }
+
+  const auto ext = opts.out.rfind('.');
+  if (ext != std::string::npos && opts.out.substr(ext) == ".npy") {
+    const std::string stem = opts.out.substr(0, ext);
+    for (size_t idx = 0; idx < entries.size(); ++idx) {
+      const auto &entry = entries[idx];
+      const std::string fname
+          = idx == 0 ? opts.out : stem + "_" + entry.name + ".npy";
+      xts::io::NpyStreamWriter<Scalar> npy(fname, entry.shape);
+      npy.append(entry.data, xts::io::n_elements(entry.shape));
+      npy.close();
+    }
+    return;
+  }
+  xts::io::NpzStreamWriter npz(opts.out);
+  for (const auto &entry : entries) {
+    npz.write_array(entry.name, entry.shape, entry.data);
+  }
+  npz.close();
+}
+
+int run(const Options &opts) {
+  const auto found = registry().find(opts.function);
+  if (found == registry().end()) {
+    throw std::invalid_argument("Unknown function " + opts.function);
+  }
+  auto func = found->second(opts);
+  if (opts.fd) {
+    // Blocks already occupy the threads, and XTPot spreads each batch of
+    // probes over its own workers
+    xts::func::FDOptions<Scalar> fd_opts;
+    fd_opts.n_threads = 1;
+    func->enable_finite_differences(fd_opts);
+  }
+  if (opts.grid && func->m_isFixed.size() != 2) {
+    throw std::invalid_argument("--grid needs a 2-D function.");
+  }
+  const auto pts
+      = opts.grid ? grid_points(*opts.grid) : load_points(opts, *func);
+
+  const auto start = std::chrono::steady_clock::now();
+  const auto res   = evaluate(opts, *func, pts);
+  const std::chrono::duration<double> elapsed
+      = std::chrono::steady_clock::now() - start;
+  write_results(opts, res);
+
+  const auto counts = func->evaluation_counts();
+  fmt::print(
+      "{}: {} points in {:.3f} s, {:.4g} points/s on {} threads\n",
+      opts.function, pts.shape(0), elapsed.count(),
+      static_cast<double>(pts.shape(0)) / elapsed.count(),
+      xts::func::parallel::resolve_threads(opts.n_threads));
+  fmt::print(
+      "evaluations: f {}, grad {}, hess {}, computed {}, cache hits {}\n",
+      counts.function_evals, counts.gradient_evals, counts.hessian_evals,
+      counts.unique_func_grad_hess, counts.cache_hits);
+  fmt::print("wrote {}\n", opts.out);
   return EXIT_SUCCESS;
 }
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  Options opts;
+  try {
+    opts = parse_args(argc, argv);
+  } catch (const std::exception &err) {
+    fmt::print(stderr, "{}\n\n{}", err.what(), usage);
+    return EXIT_FAILURE;
+  }
+  try {
+    return run(opts);
+  } catch (const std::exception &err) {
+    fmt::print(stderr, "tiny_cli: {}\n", err.what());
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,253 @@
+#pragma once
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+namespace xts {
+namespace func {
+namespace autodiff {
+
+// Forward mode automatic differentiation over N seeded directions. Dual
+// carries f and \nabla f, HyperDual additionally carries \nabla^2 f, so a
+// single evaluation of a generic kernel yields exact derivatives up to that
+// order. HyperDual is the N direction generalisation of the usual
+// (eps_1, eps_2, eps_1 eps_2) hyper-dual number, i.e. a truncated second
+// order Taylor expansion.
+// NOTE: Mixed arithmetic is only defined against scalar_type, as with the
+// SIMD kernels constants in the kernels should be ScalarType
+
+template <typename ScalarType, size_t N> struct Dual {
+  using scalar_type             = ScalarType;
+  static constexpr size_t dims  = N;
+  static constexpr size_t order = 1;
+
+  ScalarType val{0};
+  std::array<ScalarType, N> grad{};
+
+  Dual() = default;
+  explicit Dual(ScalarType value) : val(value) {}
+
+  // Independent variable idx, seeded with a unit tangent
+  static Dual variable(ScalarType value, size_t idx) {
+    Dual var(value);
+    var.grad[idx] = 1;
+    return var;
+  }
+};
+
+template <typename ScalarType, size_t N> struct HyperDual {
+  using scalar_type             = ScalarType;
+  static constexpr size_t dims  = N;
+  static constexpr size_t order = 2;
+
+  ScalarType val{0};
+  std::array<ScalarType, N> grad{};
+  std::array<std::array<ScalarType, N>, N> hess{};
+
+  HyperDual() = default;
+  explicit HyperDual(ScalarType value) : val(value) {}
+
+  static HyperDual variable(ScalarType value, size_t idx) {
+    HyperDual var(value);
+    var.grad[idx] = 1;
+    return var;
+  }
+};
+
+template <class T> struct is_ad_number : std::false_type {};
+template <typename ScalarType, size_t N>
+struct is_ad_number<Dual<ScalarType, N>> : std::true_type {};
+template <typename ScalarType, size_t N>
+struct is_ad_number<HyperDual<ScalarType, N>> : std::true_type {};
+
+template <class T>
+concept ADNumber = is_ad_number<T>::value;
+
+// Chain rule for an elementary function with value fval, first derivative
+// dfval and second derivative d2fval at x.val
+template <ADNumber D>
+D chain(
+    const D &x, typename D::scalar_type fval, typename D::scalar_type dfval,
+    typename D::scalar_type d2fval) {
+  D result(fval);
+  for (size_t idx = 0; idx < D::dims; ++idx) {
+    result.grad[idx] = dfval * x.grad[idx];
+  }
+  if constexpr (D::order > 1) {
+    for (size_t idx = 0; idx < D::dims; ++idx) {
+      for (size_t jdx = 0; jdx < D::dims; ++jdx) {
+        result.hess[idx][jdx] = dfval * x.hess[idx][jdx]
+                                + d2fval * x.grad[idx] * x.grad[jdx];
+      }
+    }
+  }
+  return result;
+}
+
+template <ADNumber D> D scaled(const D &x, typename D::scalar_type factor) {
+  D result(x.val * factor);
+  for (size_t idx = 0; idx < D::dims; ++idx) {
+    result.grad[idx] = x.grad[idx] * factor;
+  }
+  if constexpr (D::order > 1) {
+    for (size_t idx = 0; idx < D::dims; ++idx) {
+      for (size_t jdx = 0; jdx < D::dims; ++jdx) {
+        result.hess[idx][jdx] = x.hess[idx][jdx] * factor;
+      }
+    }
+  }
+  return result;
+}
+
+template <ADNumber D> D &operator+=(D &lhs, const D &rhs) {
+  lhs.val += rhs.val;
+  for (size_t idx = 0; idx < D::dims; ++idx) {
+    lhs.grad[idx] += rhs.grad[idx];
+  }
+  if constexpr (D::order > 1) {
+    for (size_t idx = 0; idx < D::dims; ++idx) {
+      for (size_t jdx = 0; jdx < D::dims; ++jdx) {
+        lhs.hess[idx][jdx] += rhs.hess[idx][jdx];
+      }
+    }
+  }
+  return lhs;
+}
+
+template <ADNumber D> D &operator-=(D &lhs, const D &rhs) {
+  return lhs += scaled(rhs, typename D::scalar_type{-1});
+}
+
+template <ADNumber D> D operator*(const D &lhs, const D &rhs) {
+  D result(lhs.val * rhs.val);
+  for (size_t idx = 0; idx < D::dims; ++idx) {
+    result.grad[idx] = lhs.grad[idx] * rhs.val + lhs.val * rhs.grad[idx];
+  }
+  if constexpr (D::order > 1) {
+    for (size_t idx = 0; idx < D::dims; ++idx) {
+      for (size_t jdx = 0; jdx < D::dims; ++jdx) {
+        result.hess[idx][jdx] = lhs.hess[idx][jdx] * rhs.val
+                                + lhs.val * rhs.hess[idx][jdx]
+                                + lhs.grad[idx] * rhs.grad[jdx]
+                                + rhs.grad[idx] * lhs.grad[jdx];
+      }
+    }
+  }
+  return result;
+}
+
+template <ADNumber D> D reciprocal(const D &x) {
+  using S         = typename D::scalar_type;
+  const S inverse = S{1} / x.val;
+  return chain(x, inverse, -inverse * inverse, 2 * inverse * inverse * inverse);
+}
+
+template <ADNumber D> D &operator*=(D &lhs, const D &rhs) {
+  lhs = lhs * rhs;
+  return lhs;
+}
+
+template <ADNumber D> D &operator/=(D &lhs, const D &rhs) {
+  lhs = lhs * reciprocal(rhs);
+  return lhs;
+}
+
+template <ADNumber D> D operator+(D lhs, const D &rhs) { return lhs += rhs; }
+template <ADNumber D> D operator-(D lhs, const D &rhs) { return lhs -= rhs; }
+template <ADNumber D> D operator/(const D &lhs, const D &rhs) {
+  return lhs * reciprocal(rhs);
+}
+template <ADNumber D> D operator-(const D &x) {
+  return scaled(x, typename D::scalar_type{-1});
+}
+template <ADNumber D> D operator+(const D &x) { return x; }
+
+// Mixed with constants
+template <ADNumber D> D operator+(D lhs, typename D::scalar_type rhs) {
+  lhs.val += rhs;
+  return lhs;
+}
+template <ADNumber D> D operator+(typename D::scalar_type lhs, D rhs) {
+  rhs.val += lhs;
+  return rhs;
+}
+template <ADNumber D> D operator-(D lhs, typename D::scalar_type rhs) {
+  lhs.val -= rhs;
+  return lhs;
+}
+template <ADNumber D> D operator-(typename D::scalar_type lhs, const D &rhs) {
+  return -rhs + lhs;
+}
+template <ADNumber D> D operator*(const D &lhs, typename D::scalar_type rhs) {
+  return scaled(lhs, rhs);
+}
+template <ADNumber D> D operator*(typename D::scalar_type lhs, const D &rhs) {
+  return scaled(rhs, lhs);
+}
+template <ADNumber D> D operator/(const D &lhs, typename D::scalar_type rhs) {
+  return scaled(lhs, typename D::scalar_type{1} / rhs);
+}
+template <ADNumber D> D operator/(typename D::scalar_type lhs, const D &rhs) {
+  return scaled(reciprocal(rhs), lhs);
+}
+
+// Elementary functions, found through ADL from the generic kernels
+template <ADNumber D> D exp(const D &x) {
+  const auto fval = std::exp(x.val);
+  return chain(x, fval, fval, fval);
+}
+
+template <ADNumber D> D log(const D &x) {
+  const auto inverse = 1 / x.val;
+  return chain(x, std::log(x.val), inverse, -inverse * inverse);
+}
+
+template <ADNumber D> D sin(const D &x) {
+  const auto sin_x = std::sin(x.val);
+  return chain(x, sin_x, std::cos(x.val), -sin_x);
+}
+
+template <ADNumber D> D cos(const D &x) {
+  const auto cos_x = std::cos(x.val);
+  return chain(x, cos_x, -std::sin(x.val), -cos_x);
+}
+
+template <ADNumber D> D sqrt(const D &x) {
+  const auto root = std::sqrt(x.val);
+  return chain(x, root, 1 / (2 * root), -1 / (4 * root * x.val));
+}
+
+// The derivative at zero is taken from the right
+template <ADNumber D> D abs(const D &x) {
+  using S = typename D::scalar_type;
+  return x.val < 0 ? scaled(x, S{-1}) : x;
+}
+
+template <ADNumber D> D pow(const D &x, typename D::scalar_type power) {
+  const auto fval = std::pow(x.val, power);
+  return chain(
+      x, fval, power * std::pow(x.val, power - 1),
+      power * (power - 1) * std::pow(x.val, power - 2));
+}
+
+// f, \nabla f and \nabla^2 f of a generic two argument kernel in one pass
+template <typename ScalarType, class Kernel>
+HyperDual<ScalarType, 2>
+jet2D(Kernel &&kernel, ScalarType x_val, ScalarType y_val) {
+  using HD = HyperDual<ScalarType, 2>;
+  return kernel(HD::variable(x_val, 0), HD::variable(y_val, 1));
+}
+
+template <typename ScalarType, class Kernel>
+Dual<ScalarType, 2>
+dual2D(Kernel &&kernel, ScalarType x_val, ScalarType y_val) {
+  using D = Dual<ScalarType, 2>;
+  return kernel(D::variable(x_val, 0), D::variable(y_val, 1));
+}
+
+} // namespace autodiff
+} // namespace func
+} // namespace xts
@@ -2,33 +2,39 @@
 // MIT License
 // Copyright 2023--present Rohit Goswami <HaoZeke>
 #include <algorithm>
+#include <atomic>
 #include <functional>
 #include <limits>
 #include <optional>
+#include <stdexcept>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
 
 #include "xtensor-blas/xlinalg.hpp"
 #include "xtensor/xarray.hpp"
+#include "xtensor/xtensor.hpp"
 
 #include "xtensor/xbuilder.hpp"
+#include "xtensor/xview.hpp"
+#include "xtsci/func/cache.hpp"
+#include "xtsci/func/counter.hpp"
+#include "xtsci/func/finite_diff.hpp"
 #include "xtsci/func/helpers.hpp"
+#include "xtsci/func/parallel.hpp"
+#include "xtsci/func/trace.hpp"
 
 namespace xts {
 namespace func {
 
-struct EvaluationCounter {
-  size_t function_evals   = 0;
-  size_t gradient_evals   = 0;
-  size_t hessian_evals    = 0;
-  size_t unique_func_grad = 0;
-};
-
 template <typename ScalarType = double> class ObjectiveFunction {
 private:
   size_t m_dims;
 
+public: // Types
+  using scalar_type = ScalarType;
+
 public: // Variables
         // TODO(rg): Better sanity checks, make m_isFixed private and check
         // m_dims on setter
@@ -61,9 +67,21 @@ public: // Constructors and destructor
 
 public: // Functions and Operators
   ScalarType operator()(const xt::xarray<ScalarType> &x) const {
-    ++m_counter.function_evals;
-    ++m_counter.unique_func_grad;
-    return this->compute(x);
+    XTSCI_TRACE_SCOPE("ObjectiveFunction::operator()");
+    m_counter.add(CounterField::function_evals);
+    if (auto cached = m_cache.value(x)) {
+      m_counter.add(CounterField::cache_hits);
+      return *cached;
+    }
+    this->count_miss();
+    if (this->fused_value_gradient()) {
+      auto [fval, grad] = this->compute_value_and_gradient(x);
+      this->store(x, fval, grad);
+      return fval;
+    }
+    ScalarType fval = this->compute(x);
+    m_cache.store_value(x, fval);
+    return fval;
   }
 
   ScalarType operator()(ScalarType x_val, ScalarType y_val) const {
@@ -73,22 +91,36 @@ public: // Functions and Operators
 
   virtual std::optional<xt::xarray<ScalarType>> gradient(
       const xt::xarray<ScalarType> &x, const bool zero_fixed = false) const {
-    ++m_counter.gradient_evals;
-    ++m_counter.unique_func_grad;
-    auto grad = this->compute_gradient(x);
+    XTSCI_TRACE_SCOPE("ObjectiveFunction::gradient");
+    m_counter.add(CounterField::gradient_evals);
+    auto grad = m_cache.gradient(x);
+    if (grad) {
+      m_counter.add(CounterField::cache_hits);
+    } else if (this->fused_value_gradient()) {
+      // The value comes from the same work, so cache it as well
+      this->count_miss();
+      auto [fval, new_grad] = this->compute_value_and_gradient(x);
+      if (!new_grad) {
+        new_grad = this->fd_gradient(x);
+      }
+      this->store(x, fval, new_grad);
+      grad = std::move(new_grad);
+    } else {
+      this->count_miss();
+      grad = this->compute_gradient(x);
+      if (!grad) {
+        grad = this->fd_gradient(x);
+      }
+      if (grad) {
+        m_cache.store_gradient(x, *grad);
+      }
+    }
     if (!grad) {
       return std::nullopt;
     }
 
-    // TODO(rg): Rethink this, zero_fixed is only there because the behavior
-    // with XTPot is wrong since the degrees of freedom are omitted there
-    // already Zero out gradients for fixed degrees of freedom
     if (zero_fixed) {
-      for (std::size_t idx = 0; idx < grad->size(); ++idx) {
-        if (m_isFixed.at(idx)) {
-          (*grad)[idx] = 0.0;
-        }
-      }
+      this->zero_fixed_gradient(*grad);
     }
 
     return grad;
@@ -96,26 +128,201 @@ public: // Functions and Operators
 
   virtual std::optional<xt::xarray<ScalarType>> hessian(
       const xt::xarray<ScalarType> &x, const bool zero_fixed = false) const {
-    ++m_counter.hessian_evals;
-    auto hess = this->compute_hessian(x);
+    XTSCI_TRACE_SCOPE("ObjectiveFunction::hessian");
+    m_counter.add(CounterField::hessian_evals);
+    auto hess = m_cache.hessian(x);
+    if (hess) {
+      m_counter.add(CounterField::cache_hits);
+    } else {
+      this->count_miss();
+      hess = this->compute_hessian(x);
+      if (!hess) {
+        hess = this->fd_hessian(x);
+      }
+      if (hess) {
+        m_cache.store_hessian(x, *hess);
+      }
+    }
     if (!hess) {
       return std::nullopt;
     }
 
-    // TODO(rg): Rethink this, see the comment for gradient
-    // Zero out Hessian rows and columns for fixed degrees of freedom
+    if (zero_fixed) {
+      this->zero_fixed_hessian(*hess);
+    }
+
+    return hess;
+  }
+
+  // Fused evaluation, a single underlying call for f and \nabla f where the
+  // subclass supports it (e.g. XTPot gets both from one potential call)
+  std::pair<ScalarType, std::optional<xt::xarray<ScalarType>>>
+  value_and_gradient(
+      const xt::xarray<ScalarType> &x, const bool zero_fixed = false) const {
+    m_counter.add(CounterField::function_evals);
+    m_counter.add(CounterField::gradient_evals);
+    auto cached_val  = m_cache.value(x);
+    auto cached_grad = m_cache.gradient(x);
+    ScalarType fval;
+    std::optional<xt::xarray<ScalarType>> grad;
+    if (cached_val && cached_grad) {
+      m_counter.add(CounterField::cache_hits);
+      fval = *cached_val;
+      grad = std::move(cached_grad);
+    } else {
+      this->count_miss();
+      std::tie(fval, grad) = this->compute_value_and_gradient(x);
+      if (!grad) {
+        grad = this->fd_gradient(x);
+      }
+      this->store(x, fval, grad);
+    }
+    if (grad && zero_fixed) {
+      this->zero_fixed_gradient(*grad);
+    }
+    return {fval, std::move(grad)};
+  }
 
+  std::tuple<
+      ScalarType, std::optional<xt::xarray<ScalarType>>,
+      std::optional<xt::xarray<ScalarType>>>
+  value_gradient_hessian(
+      const xt::xarray<ScalarType> &x, const bool zero_fixed = false) const {
+    m_counter.add(CounterField::function_evals);
+    m_counter.add(CounterField::gradient_evals);
+    m_counter.add(CounterField::hessian_evals);
+    auto cached_val  = m_cache.value(x);
+    auto cached_grad = m_cache.gradient(x);
+    auto cached_hess = m_cache.hessian(x);
+    ScalarType fval;
+    std::optional<xt::xarray<ScalarType>> grad, hess;
+    if (cached_val && cached_grad && cached_hess) {
+      m_counter.add(CounterField::cache_hits);
+      fval = *cached_val;
+      grad = std::move(cached_grad);
+      hess = std::move(cached_hess);
+    } else {
+      this->count_miss();
+      std::tie(fval, grad, hess) = this->compute_value_gradient_hessian(x);
+      if (!grad) {
+        grad = this->fd_gradient(x);
+      }
+      if (!hess) {
+        hess = this->fd_hessian(x);
+      }
+      this->store(x, fval, grad);
+      if (hess) {
+        m_cache.store_hessian(x, *hess);
+      }
+    }
     if (zero_fixed) {
-      for (size_t idx = 0; idx < hess->shape()[0]; ++idx) {
-        for (size_t jdx = 0; jdx < hess->shape()[1]; ++jdx) {
-          if (m_isFixed.at(idx) || m_isFixed.at(jdx)) {
-            (*hess)(idx, jdx) = 0;
-          }
-        }
+      if (grad) {
+        this->zero_fixed_gradient(*grad);
+      }
+      if (hess) {
+        this->zero_fixed_hessian(*hess);
       }
     }
+    return {fval, std::move(grad), std::move(hess)};
+  }
 
-    return hess;
+  // H v without forming H. Subclasses may provide the product directly
+  // through compute_hessian_matrix_product, otherwise gradients are
+  // differenced along v, see hessian_matrix_product.
+  std::optional<xt::xarray<ScalarType>> hessian_vector_product(
+      const xt::xarray<ScalarType> &x, const xt::xarray<ScalarType> &v,
+      const bool zero_fixed = false) const {
+    xt::xtensor<ScalarType, 2> dirs = xt::empty<ScalarType>(
+        {v.size(), size_t{1}});
+    std::copy(v.cbegin(), v.cend(), dirs.begin());
+    auto prod = this->hessian_matrix_product(x, dirs, zero_fixed);
+    if (!prod) {
+      return std::nullopt;
+    }
+    xt::xarray<ScalarType> result = xt::empty<ScalarType>({v.size()});
+    std::copy(prod->cbegin(), prod->cend(), result.begin());
+    return result;
+  }
+
+  // H V for the columns of V, which is (dims, n_directions). Without an
+  // analytic product each column costs one gradient per stencil probe,
+  // forward differences (the default) reuse the cached gradient at x. The
+  // stencil, step and threads follow finite_differences() when enabled, the
+  // probes of all columns are then one batch spread over the threads. With
+  // zero_fixed this is the projected P H P V, P zeroing the fixed
+  // coordinates, so neither a dense Hessian nor a dense mask is ever formed.
+  std::optional<xt::xtensor<ScalarType, 2>> hessian_matrix_product(
+      const xt::xarray<ScalarType> &x, const xt::xtensor<ScalarType, 2> &V,
+      const bool zero_fixed = false) const {
+    if (V.shape(0) != x.size()) {
+      throw std::invalid_argument(
+          "Directions need one row per coordinate of the point.");
+    }
+    m_counter.add(CounterField::hessian_evals);
+    xt::xtensor<ScalarType, 2> dirs = V;
+    // NOTE: As for batches, the mask only applies when the widths line up
+    const bool project = zero_fixed && m_isFixed.size() == x.size();
+    if (project) {
+      this->project_free_rows(dirs);
+    }
+    auto prod = this->compute_hessian_matrix_product(x, dirs);
+    if (prod) {
+      m_counter.add(CounterField::unique_func_grad_hess);
+    } else {
+      prod = this->hmp_by_differences(x, dirs);
+    }
+    if (prod && project) {
+      this->project_free_rows(*prod);
+    }
+    return prod;
+  }
+
+  // Batched evaluation, each row of pts is a point, so pts is (n_points, dims)
+  xt::xtensor<ScalarType, 1>
+  evaluate_batch(const xt::xtensor<ScalarType, 2> &pts) const {
+    // NOTE: Batches bypass the single point cache
+    this->check_batch_width(pts);
+    m_counter.add(CounterField::function_evals, pts.shape(0));
+    m_counter.add(CounterField::unique_func_grad_hess, pts.shape(0));
+    return this->compute_batch(pts);
+  }
+
+  // Returns (n_points, dims), one gradient per row of pts
+  std::optional<xt::xtensor<ScalarType, 2>> gradient_batch(
+      const xt::xtensor<ScalarType, 2> &pts,
+      const bool zero_fixed = false) const {
+    this->check_batch_width(pts);
+    m_counter.add(CounterField::gradient_evals, pts.shape(0));
+    m_counter.add(CounterField::unique_func_grad_hess, pts.shape(0));
+    auto grads = this->compute_gradient_batch(pts);
+    if (!grads) {
+      grads = this->fd_gradient_batch(pts);
+    }
+    if (grads && zero_fixed) {
+      this->zero_fixed_columns(*grads);
+    }
+    return grads;
+  }
+
+  // Fused batch, values and (n_points, dims) gradients from one underlying
+  // call per point where the subclass supports it
+  std::pair<
+      xt::xtensor<ScalarType, 1>, std::optional<xt::xtensor<ScalarType, 2>>>
+  value_and_gradient_batch(
+      const xt::xtensor<ScalarType, 2> &pts,
+      const bool zero_fixed = false) const {
+    this->check_batch_width(pts);
+    m_counter.add(CounterField::function_evals, pts.shape(0));
+    m_counter.add(CounterField::gradient_evals, pts.shape(0));
+    m_counter.add(CounterField::unique_func_grad_hess, pts.shape(0));
+    auto [vals, grads] = this->compute_value_and_gradient_batch(pts);
+    if (!grads) {
+      grads = this->fd_gradient_batch(pts);
+    }
+    if (grads && zero_fixed) {
+      this->zero_fixed_columns(*grads);
+    }
+    return {std::move(vals), std::move(grads)};
   }
 
   ScalarType directional_derivative(
@@ -139,10 +346,293 @@ public: // Functions and Operators
     return {parallel_projection, perpendicular_projection};
   }
 
-  EvaluationCounter evaluation_counts() const { return m_counter; }
+  // Safe to call while other threads evaluate, counts are summed over the
+  // per-thread shards
+  EvaluationCounter evaluation_counts() const { return m_counter.snapshot(); }
+
+  // Counts accumulated since an earlier evaluation_counts() snapshot
+  EvaluationCounter
+  evaluation_counts_since(const EvaluationCounter &before) const {
+    return m_counter.snapshot() - before;
+  }
+
+  // Returns the counts from before the reset
+  EvaluationCounter reset_evaluation_counts() const {
+    EvaluationCounter before = m_counter.snapshot();
+    m_counter.reset();
+    return before;
+  }
+
+  // True when points hold only the free coordinates (as for XTPot) rather
+  // than every coordinate of m_isFixed
+  virtual bool points_are_free() const { return false; }
+
+  // Cache controls, see EvaluationCache
+  void enable_cache(bool enabled = true) { m_cache.enable(enabled); }
+  bool cache_enabled() const { return m_cache.enabled(); }
+  void set_cache_tolerance(ScalarType tol) { m_cache.set_tolerance(tol); }
+  ScalarType cache_tolerance() const { return m_cache.tolerance(); }
+  void clear_cache() const { m_cache.clear(); }
+
+  // Finite difference fallback for derivatives the subclass does not provide,
+  // off by default. Fixed degrees of freedom are never displaced, their
+  // gradient components and Hessian rows / columns are zero.
+  // NOTE: The displaced points go through compute_batch (and
+  // compute_gradient_batch for Hessians) in blocks which run concurrently
+  // unless n_threads is 1
+  void enable_finite_differences(const FDOptions<ScalarType> &opts = {}) {
+    m_fd = opts;
+    m_cache.clear();
+  }
+  void disable_finite_differences() {
+    m_fd.reset();
+    m_cache.clear();
+  }
+  const std::optional<FDOptions<ScalarType>> &finite_differences() const {
+    return m_fd;
+  }
 
 private:
-  mutable EvaluationCounter m_counter;
+  mutable ShardedCounter m_counter;
+  mutable EvaluationCache<ScalarType> m_cache;
+  std::optional<FDOptions<ScalarType>> m_fd;
+
+  void count_miss() const {
+    m_counter.add(CounterField::cache_misses);
+    m_counter.add(CounterField::unique_func_grad_hess);
+  }
+
+  void store(
+      const xt::xarray<ScalarType> &x, ScalarType fval,
+      const std::optional<xt::xarray<ScalarType>> &grad) const {
+    m_cache.store_value(x, fval);
+    if (grad) {
+      m_cache.store_gradient(x, *grad);
+    }
+  }
+
+  // Batch kernels index rows blindly, so a row is every coordinate or, when
+  // points_are_free, only the free ones
+  void check_batch_width(const xt::xtensor<ScalarType, 2> &pts) const {
+    size_t width = m_isFixed.size();
+    if (this->points_are_free()) {
+      width = static_cast<size_t>(
+          std::count(m_isFixed.cbegin(), m_isFixed.cend(), false));
+    }
+    if (pts.shape(1) != width) {
+      throw std::invalid_argument(
+          "Batch points need one column per coordinate of the function.");
+    }
+  }
+
+  // Coordinates the finite differences displace, the mask is only applied
+  // when it matches the width of x (XTPot points are already free only)
+  std::vector<size_t> fd_dofs(const xt::xarray<ScalarType> &x) const {
+    const bool masked = m_isFixed.size() == x.size();
+    std::vector<size_t> dofs;
+    dofs.reserve(x.size());
+    for (size_t idx = 0; idx < x.size(); ++idx) {
+      if (!masked || !m_isFixed(idx)) {
+        dofs.push_back(idx);
+      }
+    }
+    return dofs;
+  }
+
+  // Finite difference probes are evaluated as batches, one contiguous block
+  // of rows per worker. Each block is a single batched call, so XTPot spreads
+  // it over its own workers rather than serialising on the shared potential.
+  // fn(chunk, rows) gets the rows of pts as a contiguous batch.
+  template <class Fn>
+  void for_probe_blocks(
+      const xt::xtensor<ScalarType, 2> &pts, size_t n_threads, Fn &&fn) const {
+    const size_t n_rows    = pts.shape(0);
+    const size_t n_workers = parallel::n_workers(n_rows, n_threads);
+    const size_t per_block = (n_rows + n_workers - 1) / n_workers;
+    if (n_workers <= 1) {
+      fn(pts, xt::range(size_t{0}, n_rows));
+      return;
+    }
+    const size_t n_blocks = (n_rows + per_block - 1) / per_block;
+    parallel::parallel_for(n_blocks, n_threads, [&](size_t, size_t block) {
+      const size_t lo = block * per_block;
+      const auto rows = xt::range(lo, std::min(n_rows, lo + per_block));
+      const xt::xtensor<ScalarType, 2> chunk = xt::view(pts, rows, xt::all());
+      fn(chunk, rows);
+    });
+  }
+
+  xt::xtensor<ScalarType, 1>
+  probe_values(const xt::xtensor<ScalarType, 2> &pts, size_t n_threads) const {
+    xt::xtensor<ScalarType, 1> vals = xt::empty<ScalarType>({pts.shape(0)});
+    this->for_probe_blocks(pts, n_threads, [&](const auto &chunk, auto rows) {
+      xt::view(vals, rows) = this->compute_batch(chunk);
+    });
+    return vals;
+  }
+
+  // nullopt without an analytic gradient
+  std::optional<xt::xtensor<ScalarType, 2>> probe_gradients(
+      const xt::xtensor<ScalarType, 2> &pts, size_t n_threads) const {
+    xt::xtensor<ScalarType, 2> grads = xt::empty<ScalarType>(pts.shape());
+    std::atomic<bool> analytic{true};
+    this->for_probe_blocks(pts, n_threads, [&](const auto &chunk, auto rows) {
+      auto chunk_grads = this->compute_gradient_batch(chunk);
+      if (!chunk_grads) {
+        analytic = false;
+        return;
+      }
+      xt::view(grads, rows, xt::all()) = *chunk_grads;
+    });
+    if (!analytic) {
+      return std::nullopt;
+    }
+    return grads;
+  }
+
+  std::optional<xt::xarray<ScalarType>>
+  fd_gradient(const xt::xarray<ScalarType> &x) const {
+    if (!m_fd) {
+      return std::nullopt;
+    }
+    const auto dofs   = this->fd_dofs(x);
+    const auto probes = fd::coordinate_probes(
+        x, dofs, *m_fd, m_fd->stencil == FDStencil::forward);
+    m_counter.add(CounterField::unique_func_grad_hess, probes.points.shape(0));
+    return fd::gradient(
+        this->probe_values(probes.points, m_fd->n_threads), probes, x, dofs,
+        *m_fd);
+  }
+
+  // Rows in turn, the displacements of a row are one threaded batch
+  std::optional<xt::xtensor<ScalarType, 2>>
+  fd_gradient_batch(const xt::xtensor<ScalarType, 2> &pts) const {
+    if (!m_fd) {
+      return std::nullopt;
+    }
+    const size_t ndim                = pts.shape(1);
+    xt::xtensor<ScalarType, 2> grads = xt::empty<ScalarType>(
+        {pts.shape(0), ndim});
+    xt::xarray<ScalarType> point = xt::empty<ScalarType>({ndim});
+    for (size_t idx = 0; idx < pts.shape(0); ++idx) {
+      std::copy_n(&pts(idx, 0), ndim, point.begin());
+      auto grad = this->fd_gradient(point);
+      std::copy_n(grad->begin(), ndim, &grads(idx, 0));
+    }
+    return grads;
+  }
+
+  // NOTE: XTPot points only carry the free degrees of freedom, the mask is
+  // only meaningful when the widths line up
+  void zero_fixed_columns(xt::xtensor<ScalarType, 2> &grads) const {
+    if (m_isFixed.size() != grads.shape(1)) {
+      return;
+    }
+    for (size_t jdx = 0; jdx < grads.shape(1); ++jdx) {
+      if (m_isFixed(jdx)) {
+        xt::view(grads, xt::all(), jdx) = 0.0;
+      }
+    }
+  }
+
+  // Columns are differences of the analytic gradient when there is one, else
+  // of finite difference gradients. Whether there is one is only known from
+  // the probe batch itself, which is then reused for the fallback.
+  std::optional<xt::xarray<ScalarType>>
+  fd_hessian(const xt::xarray<ScalarType> &x) const {
+    if (!m_fd) {
+      return std::nullopt;
+    }
+    const auto dofs   = this->fd_dofs(x);
+    const auto probes = fd::coordinate_probes(
+        x, dofs, *m_fd, m_fd->stencil == FDStencil::forward);
+    auto grads = this->probe_gradients(probes.points, m_fd->n_threads);
+    if (grads) {
+      m_counter.add(
+          CounterField::unique_func_grad_hess, probes.points.shape(0));
+    } else {
+      // fd_gradient counts its own probes
+      grads = this->fd_gradient_batch(probes.points);
+    }
+    return fd::hessian(*grads, probes, x, dofs, *m_fd);
+  }
+
+  // TODO(rg): Rethink this, zero_fixed is only there because the behavior
+  // with XTPot is wrong since the degrees of freedom are omitted there
+  // already Zero out gradients for fixed degrees of freedom
+  void zero_fixed_gradient(xt::xarray<ScalarType> &grad) const {
+    for (std::size_t idx = 0; idx < grad.size(); ++idx) {
+      if (m_isFixed.at(idx)) {
+        grad[idx] = 0.0;
+      }
+    }
+  }
+
+  // Zero out Hessian rows and columns for fixed degrees of freedom, only the
+  // fixed indices are visited
+  void zero_fixed_hessian(xt::xarray<ScalarType> &hess) const {
+    const size_t ndim = std::min<size_t>(m_isFixed.size(), hess.shape(0));
+    for (size_t idx = 0; idx < ndim; ++idx) {
+      if (m_isFixed(idx)) {
+        xt::view(hess, idx, xt::all()) = 0;
+        xt::view(hess, xt::all(), idx) = 0;
+      }
+    }
+  }
+
+  // Applies the projection onto the free coordinates to each column of mat
+  void project_free_rows(xt::xtensor<ScalarType, 2> &mat) const {
+    for (size_t idx = 0; idx < mat.shape(0); ++idx) {
+      if (m_isFixed(idx)) {
+        xt::view(mat, idx, xt::all()) = 0;
+      }
+    }
+  }
+
+  // Columns of H V as directional differences of the gradient, which is the
+  // analytic one when available, else a finite difference gradient. The
+  // probes of every column form one threaded batch.
+  std::optional<xt::xtensor<ScalarType, 2>> hmp_by_differences(
+      const xt::xarray<ScalarType> &x,
+      const xt::xtensor<ScalarType, 2> &dirs) const {
+    FDOptions<ScalarType> opts{FDStencil::forward, 0, 1};
+    if (m_fd) {
+      opts = *m_fd;
+    }
+    // Also tells whether there is a gradient at all
+    const auto g_x = this->gradient(x);
+    if (!g_x) {
+      return std::nullopt;
+    }
+    xt::xtensor<ScalarType, 2> prod = xt::zeros<ScalarType>(dirs.shape());
+    // Zero directions are skipped
+    std::vector<size_t> cols;
+    for (size_t col = 0; col < dirs.shape(1); ++col) {
+      if (xt::amax(xt::abs(xt::view(dirs, xt::all(), col)))() != 0) {
+        cols.push_back(col);
+      }
+    }
+    if (cols.empty()) {
+      return prod;
+    }
+    const auto probes = fd::directional_probes(x, dirs, cols, opts);
+    auto grads        = this->probe_gradients(probes.points, opts.n_threads);
+    if (grads) {
+      m_counter.add(
+          CounterField::unique_func_grad_hess, probes.points.shape(0));
+    } else {
+      // Only reachable with finite differences enabled, else g_x is unset
+      grads = this->fd_gradient_batch(probes.points);
+    }
+    xt::xtensor<ScalarType, 1> at_x = xt::empty<ScalarType>({g_x->size()});
+    std::copy(g_x->cbegin(), g_x->cend(), at_x.begin());
+    const auto diffs
+        = fd::gradient_differences(*grads, probes, at_x, opts.stencil);
+    for (size_t task = 0; task < cols.size(); ++task) {
+      xt::view(prod, xt::all(), cols[task]) = xt::view(diffs, xt::all(), task);
+    }
+    return prod;
+  }
 
   virtual ScalarType compute(const xt::xarray<ScalarType> &x) const = 0;
 
@@ -155,6 +645,79 @@ private:
   compute_hessian(const xt::xarray<ScalarType> &) const {
     return std::nullopt;
   }
+
+  // Analytic H V, by default multiplied out from compute_hessian so that
+  // subclasses with a cheap dense Hessian need nothing more. Large systems
+  // should override this instead of compute_hessian.
+  virtual std::optional<xt::xtensor<ScalarType, 2>>
+  compute_hessian_matrix_product(
+      const xt::xarray<ScalarType> &x,
+      const xt::xtensor<ScalarType, 2> &dirs) const {
+    auto hess = this->compute_hessian(x);
+    if (!hess) {
+      return std::nullopt;
+    }
+    xt::xtensor<ScalarType, 2> prod = xt::linalg::dot(*hess, dirs);
+    return prod;
+  }
+
+  // When true, a function value or gradient miss computes both and caches
+  // them, worthwhile when they come from the same work
+  virtual bool fused_value_gradient() const { return false; }
+
+  // Subclasses which get f and \nabla f from the same work should override
+  // this, the default simply makes both calls
+  virtual std::pair<ScalarType, std::optional<xt::xarray<ScalarType>>>
+  compute_value_and_gradient(const xt::xarray<ScalarType> &x) const {
+    return {this->compute(x), this->compute_gradient(x)};
+  }
+
+  virtual std::tuple<
+      ScalarType, std::optional<xt::xarray<ScalarType>>,
+      std::optional<xt::xarray<ScalarType>>>
+  compute_value_gradient_hessian(const xt::xarray<ScalarType> &x) const {
+    auto [fval, grad] = this->compute_value_and_gradient(x);
+    return {fval, std::move(grad), this->compute_hessian(x)};
+  }
+
+  // Fallbacks for the batched API, these reuse a single point buffer and
+  // should be overridden when a tighter loop is possible
+  virtual xt::xtensor<ScalarType, 1>
+  compute_batch(const xt::xtensor<ScalarType, 2> &pts) const {
+    const size_t npts                 = pts.shape(0);
+    const size_t ndim                 = pts.shape(1);
+    xt::xtensor<ScalarType, 1> result = xt::empty<ScalarType>({npts});
+    xt::xarray<ScalarType> point      = xt::empty<ScalarType>({ndim});
+    for (size_t idx = 0; idx < npts; ++idx) {
+      std::copy_n(&pts(idx, 0), ndim, point.begin());
+      result(idx) = this->compute(point);
+    }
+    return result;
+  }
+
+  virtual std::optional<xt::xtensor<ScalarType, 2>>
+  compute_gradient_batch(const xt::xtensor<ScalarType, 2> &pts) const {
+    const size_t npts                 = pts.shape(0);
+    const size_t ndim                 = pts.shape(1);
+    xt::xtensor<ScalarType, 2> result = xt::empty<ScalarType>({npts, ndim});
+    xt::xarray<ScalarType> point      = xt::empty<ScalarType>({ndim});
+    for (size_t idx = 0; idx < npts; ++idx) {
+      std::copy_n(&pts(idx, 0), ndim, point.begin());
+      auto grad = this->compute_gradient(point);
+      if (!grad) {
+        return std::nullopt;
+      }
+      std::copy_n(grad->begin(), ndim, &result(idx, 0));
+    }
+    return result;
+  }
+
+  virtual std::pair<
+      xt::xtensor<ScalarType, 1>, std::optional<xt::xtensor<ScalarType, 2>>>
+  compute_value_and_gradient_batch(
+      const xt::xtensor<ScalarType, 2> &pts) const {
+    return {this->compute_batch(pts), this->compute_gradient_batch(pts)};
+  }
 };
 
 } // namespace func
@@ -0,0 +1,373 @@
+#pragma once
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include "xtensor/xarray.hpp"
+#include "xtensor/xbuilder.hpp"
+#include "xtensor/xmath.hpp"
+#include "xtensor/xtensor.hpp"
+#include "xtensor/xview.hpp"
+
+#include "xtsci/func/base.hpp"
+
+namespace xts {
+namespace func {
+
+// Hessian of a function of N three dimensional sites (atoms) kept as 3x3
+// blocks in compressed sparse row order, block (i, j) couples site i to site
+// j. The pattern is fixed on construction and always holds the diagonal
+// blocks, so memory grows with the number of coupled pairs rather than N^2.
+template <typename ScalarType = double> class BlockSparseHessian {
+public: // Types
+  static constexpr size_t block_dim = 3;
+  using block_type = std::array<ScalarType, block_dim * block_dim>; // Row major
+
+public: // Constructors
+  BlockSparseHessian() = default;
+
+  // neighbours[i] lists the sites coupled to site i, in any order and with or
+  // without i itself, the pattern is expected to be symmetric
+  explicit BlockSparseHessian(
+      const std::vector<std::vector<size_t>> &neighbours) {
+    const size_t n_sites = neighbours.size();
+    m_row_ptr.assign(n_sites + 1, 0);
+    for (size_t idx = 0; idx < n_sites; ++idx) {
+      std::vector<size_t> row = neighbours[idx];
+      row.push_back(idx);
+      std::sort(row.begin(), row.end());
+      row.erase(std::unique(row.begin(), row.end()), row.end());
+      if (row.back() >= n_sites) {
+        throw std::invalid_argument("Neighbour index exceeds the site count.");
+      }
+      m_col_idx.insert(m_col_idx.end(), row.begin(), row.end());
+      m_row_ptr[idx + 1] = m_col_idx.size();
+    }
+    m_blocks.assign(m_col_idx.size(), block_type{});
+  }
+
+public: // Functions
+  size_t n_sites() const {
+    return m_row_ptr.empty() ? 0 : m_row_ptr.size() - 1;
+  }
+  size_t n_blocks() const { return m_col_idx.size(); }
+  // Rows (and columns) of the equivalent dense matrix
+  size_t size() const { return block_dim * this->n_sites(); }
+
+  // Null when (idx, jdx) is outside the pattern
+  block_type *find(size_t idx, size_t jdx) {
+    const auto pos = this->position(idx, jdx);
+    return pos ? &m_blocks[*pos] : nullptr;
+  }
+  const block_type *find(size_t idx, size_t jdx) const {
+    const auto pos = this->position(idx, jdx);
+    return pos ? &m_blocks[*pos] : nullptr;
+  }
+
+  // Element of the dense matrix, zero outside the pattern
+  ScalarType operator()(size_t row, size_t col) const {
+    const block_type *block = this->find(row / block_dim, col / block_dim);
+    return block ? (*block)[(row % block_dim) * block_dim + col % block_dim]
+                 : ScalarType{0};
+  }
+
+  // Compressed sparse row storage, blocks()[k] sits in the row whose range
+  // of row_ptr() contains k, at block column col_idx()[k]
+  const std::vector<size_t> &row_ptr() const { return m_row_ptr; }
+  const std::vector<size_t> &col_idx() const { return m_col_idx; }
+  const std::vector<block_type> &blocks() const { return m_blocks; }
+  std::vector<block_type> &blocks() { return m_blocks; }
+
+  // Averages block (i, j) with the transpose of block (j, i)
+  void symmetrize() {
+    for (size_t idx = 0; idx < this->n_sites(); ++idx) {
+      for (size_t kdx = m_row_ptr[idx]; kdx < m_row_ptr[idx + 1]; ++kdx) {
+        const size_t jdx = m_col_idx[kdx];
+        if (jdx < idx) {
+          continue;
+        }
+        block_type *lower = this->find(jdx, idx);
+        if (lower == nullptr) {
+          continue; // Only for asymmetric patterns
+        }
+        block_type &upper = m_blocks[kdx];
+        for (size_t row = 0; row < block_dim; ++row) {
+          for (size_t col = 0; col < block_dim; ++col) {
+            ScalarType &above    = upper[row * block_dim + col];
+            ScalarType &below    = (*lower)[col * block_dim + row];
+            const ScalarType avg = (above + below) / 2;
+            above                = avg;
+            below                = avg;
+          }
+        }
+      }
+    }
+  }
+
+  // H v, linear in the number of blocks
+  xt::xarray<ScalarType> dot(const xt::xarray<ScalarType> &vec) const {
+    if (vec.size() != this->size()) {
+      throw std::invalid_argument("Vector does not match the Hessian size.");
+    }
+    xt::xarray<ScalarType> result = xt::zeros<ScalarType>({this->size()});
+    for (size_t idx = 0; idx < this->n_sites(); ++idx) {
+      for (size_t kdx = m_row_ptr[idx]; kdx < m_row_ptr[idx + 1]; ++kdx) {
+        const size_t jdx        = m_col_idx[kdx];
+        const block_type &block = m_blocks[kdx];
+        for (size_t row = 0; row < block_dim; ++row) {
+          for (size_t col = 0; col < block_dim; ++col) {
+            result.flat(idx * block_dim + row)
+                += block[row * block_dim + col]
+                   * vec.flat(jdx * block_dim + col);
+          }
+        }
+      }
+    }
+    return result;
+  }
+
+  // Dense (3N, 3N) copy, only sensible for small systems
+  xt::xarray<ScalarType> to_dense() const {
+    const size_t ndim             = this->size();
+    xt::xarray<ScalarType> result = xt::zeros<ScalarType>({ndim, ndim});
+    for (size_t idx = 0; idx < this->n_sites(); ++idx) {
+      for (size_t kdx = m_row_ptr[idx]; kdx < m_row_ptr[idx + 1]; ++kdx) {
+        const size_t jdx = m_col_idx[kdx];
+        for (size_t row = 0; row < block_dim; ++row) {
+          for (size_t col = 0; col < block_dim; ++col) {
+            result(idx * block_dim + row, jdx * block_dim + col)
+                = m_blocks[kdx][row * block_dim + col];
+          }
+        }
+      }
+    }
+    return result;
+  }
+
+private:
+  std::vector<size_t> m_row_ptr;
+  std::vector<size_t> m_col_idx;
+  std::vector<block_type> m_blocks;
+
+  std::optional<size_t> position(size_t idx, size_t jdx) const {
+    if (idx >= this->n_sites()) {
+      return std::nullopt;
+    }
+    const auto first = m_col_idx.begin() + m_row_ptr[idx];
+    const auto last  = m_col_idx.begin() + m_row_ptr[idx + 1];
+    const auto found = std::lower_bound(first, last, jdx);
+    if (found == last || *found != jdx) {
+      return std::nullopt;
+    }
+    return static_cast<size_t>(found - m_col_idx.begin());
+  }
+};
+
+// Pairs of sites within cutoff of each other, positions is (n_sites, 3).
+// Axes with a positive box length are periodic under the minimum image
+// convention (orthorhombic cells). Sites are binned into cells at least
+// cutoff wide and only adjacent cells are compared, so for a fixed density
+// the cost is linear in the number of sites.
+template <typename ScalarType>
+std::vector<std::vector<size_t>> neighbours_within(
+    const xt::xtensor<ScalarType, 2> &positions, ScalarType cutoff,
+    const std::array<ScalarType, 3> &box_lengths = {}) {
+  if (!(cutoff > 0)) {
+    throw std::invalid_argument("Neighbour cutoff must be positive.");
+  }
+  const size_t n_sites = positions.shape(0);
+  std::vector<std::vector<size_t>> neighbours(n_sites);
+  if (n_sites == 0) {
+    return neighbours;
+  }
+
+  // Cap the cells per axis, keeping the bin count within a small multiple of
+  // the site count however sparse the sites are
+  const size_t max_cells = 2 * static_cast<size_t>(std::ceil(
+                                   std::cbrt(static_cast<double>(n_sites))));
+  std::array<ScalarType, 3> lower{}, width{};
+  std::array<size_t, 3> n_cells{};
+  for (size_t ax = 0; ax < 3; ++ax) {
+    ScalarType extent = box_lengths[ax];
+    if (!(extent > 0)) {
+      auto column = xt::view(positions, xt::all(), ax);
+      lower[ax]   = xt::amin(column)();
+      extent      = xt::amax(column)() - lower[ax];
+    }
+    const ScalarType fits = std::min(
+        extent / cutoff, static_cast<ScalarType>(max_cells));
+    n_cells[ax] = std::max<size_t>(static_cast<size_t>(fits), 1);
+    // Periodic neighbours are only distinct with three or more cells
+    if (box_lengths[ax] > 0 && n_cells[ax] < 3) {
+      n_cells[ax] = 1;
+    }
+    width[ax] = extent / static_cast<ScalarType>(n_cells[ax]);
+  }
+
+  auto wrapped = [&](size_t site, size_t ax) {
+    ScalarType coord = positions(site, ax);
+    if (box_lengths[ax] > 0) {
+      coord -= box_lengths[ax] * std::floor(coord / box_lengths[ax]);
+    }
+    return coord;
+  };
+  auto cell_index = [&](const std::array<size_t, 3> &cell) {
+    return (cell[0] * n_cells[1] + cell[1]) * n_cells[2] + cell[2];
+  };
+  std::vector<std::array<size_t, 3>> site_cell(n_sites);
+  std::vector<std::vector<size_t>> bins(n_cells[0] * n_cells[1] * n_cells[2]);
+  for (size_t site = 0; site < n_sites; ++site) {
+    for (size_t ax = 0; ax < 3; ++ax) {
+      const ScalarType offset = wrapped(site, ax) - lower[ax];
+      const auto cell
+          = width[ax] > 0 ? static_cast<size_t>(offset / width[ax]) : 0;
+      site_cell[site][ax] = std::min(cell, n_cells[ax] - 1);
+    }
+    bins[cell_index(site_cell[site])].push_back(site);
+  }
+
+  const ScalarType cutoff_sq = cutoff * cutoff;
+  for (size_t site = 0; site < n_sites; ++site) {
+    const auto &home = site_cell[site];
+    for (int dx = -1; dx <= 1; ++dx) {
+      for (int dy = -1; dy <= 1; ++dy) {
+        for (int dz = -1; dz <= 1; ++dz) {
+          const std::array<int, 3> shift{dx, dy, dz};
+          std::array<size_t, 3> cell{};
+          bool in_range = true;
+          for (size_t ax = 0; ax < 3 && in_range; ++ax) {
+            const auto n_ax = static_cast<long>(n_cells[ax]);
+            long target     = static_cast<long>(home[ax]) + shift[ax];
+            if (n_ax == 1) {
+              in_range = shift[ax] == 0;
+            } else if (box_lengths[ax] > 0) {
+              target = (target + n_ax) % n_ax;
+            } else {
+              in_range = target >= 0 && target < n_ax;
+            }
+            cell[ax] = static_cast<size_t>(target);
+          }
+          if (!in_range) {
+            continue;
+          }
+          for (size_t other : bins[cell_index(cell)]) {
+            if (other <= site) {
+              continue;
+            }
+            ScalarType dist_sq = 0;
+            for (size_t ax = 0; ax < 3; ++ax) {
+              ScalarType delta = positions(site, ax) - positions(other, ax);
+              if (box_lengths[ax] > 0) {
+                delta -= box_lengths[ax]
+                         * std::round(delta / box_lengths[ax]);
+              }
+              dist_sq += delta * delta;
+            }
+            if (dist_sq <= cutoff_sq) {
+              neighbours[site].push_back(other);
+              neighbours[other].push_back(site);
+            }
+          }
+        }
+      }
+    }
+  }
+  return neighbours;
+}
+
+// Greedy distance two colouring: sites of one colour share no neighbour, so
+// displacing all of them together still separates their Hessian columns.
+// The colour count depends on the local coordination, not on the site count.
+inline std::vector<size_t>
+distance2_coloring(const std::vector<std::vector<size_t>> &neighbours) {
+  const size_t n_sites   = neighbours.size();
+  constexpr size_t unset = static_cast<size_t>(-1);
+  std::vector<size_t> colors(n_sites, unset);
+  // forbidden[c] == site marks colour c as taken around site
+  std::vector<size_t> forbidden;
+  for (size_t site = 0; site < n_sites; ++site) {
+    auto mark = [&](size_t other) {
+      if (other != site && colors[other] != unset) {
+        forbidden[colors[other]] = site;
+      }
+    };
+    for (size_t near : neighbours[site]) {
+      mark(near);
+      for (size_t next : neighbours[near]) {
+        mark(next);
+      }
+    }
+    size_t color = 0;
+    while (color < forbidden.size() && forbidden[color] == site) {
+      ++color;
+    }
+    if (color == forbidden.size()) {
+      forbidden.push_back(unset);
+    }
+    colors[site] = color;
+  }
+  return colors;
+}
+
+// Block sparse Hessian of func at x, which holds three coordinates per site,
+// for the coupling pattern in neighbours; couplings outside the pattern are
+// taken to vanish. The sites of each colour are displaced together along
+// one axis, so the 3 * n_colours columns of a single hessian_matrix_product
+// carry every block. Stencil, threads and gradient reuse are those of
+// hessian_matrix_product.
+template <typename ScalarType>
+std::optional<BlockSparseHessian<ScalarType>> sparse_hessian(
+    const ObjectiveFunction<ScalarType> &func, const xt::xarray<ScalarType> &x,
+    const std::vector<std::vector<size_t>> &neighbours) {
+  constexpr size_t block_dim = BlockSparseHessian<ScalarType>::block_dim;
+  const size_t n_sites       = neighbours.size();
+  if (x.size() != block_dim * n_sites) {
+    throw std::invalid_argument(
+        "Point needs three coordinates for every site of the pattern.");
+  }
+  BlockSparseHessian<ScalarType> hess(neighbours);
+  const auto colors = distance2_coloring(neighbours);
+  size_t n_colors   = 0;
+  for (size_t color : colors) {
+    n_colors = std::max(n_colors, color + 1);
+  }
+
+  xt::xtensor<ScalarType, 2> seeds
+      = xt::zeros<ScalarType>({x.size(), block_dim * n_colors});
+  for (size_t site = 0; site < n_sites; ++site) {
+    for (size_t ax = 0; ax < block_dim; ++ax) {
+      seeds(site * block_dim + ax, colors[site] * block_dim + ax) = 1;
+    }
+  }
+  const auto compressed = func.hessian_matrix_product(x, seeds);
+  if (!compressed) {
+    return std::nullopt;
+  }
+
+  // Rows coupled to site j only see the displacement of j within its colour
+  const auto &row_ptr = hess.row_ptr();
+  const auto &col_idx = hess.col_idx();
+  auto &blocks        = hess.blocks();
+  for (size_t idx = 0; idx < n_sites; ++idx) {
+    for (size_t kdx = row_ptr[idx]; kdx < row_ptr[idx + 1]; ++kdx) {
+      const size_t color = colors[col_idx[kdx]];
+      for (size_t row = 0; row < block_dim; ++row) {
+        for (size_t col = 0; col < block_dim; ++col) {
+          blocks[kdx][row * block_dim + col] = (*compressed)(
+              idx * block_dim + row, color * block_dim + col);
+        }
+      }
+    }
+  }
+  hess.symmetrize();
+  return hess;
+}
+
+} // namespace func
+} // namespace xts
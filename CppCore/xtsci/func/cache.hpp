@@ -0,0 +1,180 @@
+#pragma once
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+#include "xtensor/xarray.hpp"
+
+namespace xts {
+namespace func {
+
+// Remembers f, \nabla f and \nabla^2 f at the last point seen, separately on
+// every thread. A new point invalidates everything, points within the
+// tolerance (max-norm) of the stored one are treated as identical. Entries
+// live in a few thread local slots keyed by the cache's id, so lookups take
+// no lock and concurrent callers of one function never evict each other;
+// clear() bumps an epoch which retires the entries of every thread at once.
+// Caches whose ids share a slot on the same thread evict each other, which
+// only costs a recomputation.
+// NOTE: Copies share the configuration but start out empty
+template <typename ScalarType = double> class EvaluationCache {
+public:
+  EvaluationCache() = default;
+  EvaluationCache(const EvaluationCache &other)
+      : m_enabled(other.enabled()), m_tol(other.tolerance()) {}
+  EvaluationCache &operator=(const EvaluationCache &other) {
+    if (this != &other) {
+      m_enabled.store(other.enabled(), std::memory_order_relaxed);
+      m_tol.store(other.tolerance(), std::memory_order_relaxed);
+      this->clear();
+    }
+    return *this;
+  }
+
+  std::optional<ScalarType> value(const xt::xarray<ScalarType> &x) const {
+    const Entry *entry = this->lookup(x);
+    if (entry == nullptr) {
+      return std::nullopt;
+    }
+    return entry->value;
+  }
+
+  std::optional<xt::xarray<ScalarType>>
+  gradient(const xt::xarray<ScalarType> &x) const {
+    const Entry *entry = this->lookup(x);
+    if (entry == nullptr) {
+      return std::nullopt;
+    }
+    return entry->gradient;
+  }
+
+  std::optional<xt::xarray<ScalarType>>
+  hessian(const xt::xarray<ScalarType> &x) const {
+    const Entry *entry = this->lookup(x);
+    if (entry == nullptr) {
+      return std::nullopt;
+    }
+    return entry->hessian;
+  }
+
+  void store_value(const xt::xarray<ScalarType> &x, ScalarType fval) {
+    if (Entry *entry = this->rebase(x)) {
+      entry->value = fval;
+    }
+  }
+
+  void store_gradient(
+      const xt::xarray<ScalarType> &x, const xt::xarray<ScalarType> &grad) {
+    if (Entry *entry = this->rebase(x)) {
+      entry->gradient = grad;
+    }
+  }
+
+  void store_hessian(
+      const xt::xarray<ScalarType> &x, const xt::xarray<ScalarType> &hess) {
+    if (Entry *entry = this->rebase(x)) {
+      entry->hessian = hess;
+    }
+  }
+
+  void clear() { m_epoch.fetch_add(1, std::memory_order_relaxed); }
+
+  void enable(bool enabled = true) {
+    m_enabled.store(enabled, std::memory_order_relaxed);
+    if (!enabled) {
+      this->clear();
+    }
+  }
+  bool enabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+  // A zero tolerance requires bitwise equal inputs
+  void set_tolerance(ScalarType tol) {
+    if (tol < 0) {
+      throw std::invalid_argument("Cache tolerance must be non-negative.");
+    }
+    m_tol.store(tol, std::memory_order_relaxed);
+  }
+  ScalarType tolerance() const {
+    return m_tol.load(std::memory_order_relaxed);
+  }
+
+private:
+  static constexpr size_t n_slots = 8;
+  struct Entry {
+    uint64_t owner = 0; // Id of the cache holding the slot, ids start at 1
+    uint64_t epoch = 0;
+    xt::xarray<ScalarType> point;
+    std::optional<ScalarType> value;
+    std::optional<xt::xarray<ScalarType>> gradient;
+    std::optional<xt::xarray<ScalarType>> hessian;
+  };
+
+  const uint64_t m_id{next_id()};
+  std::atomic<bool> m_enabled{true};
+  std::atomic<ScalarType> m_tol{0};
+  std::atomic<uint64_t> m_epoch{0};
+
+  // Never reused, so a slot left behind by a destroyed cache cannot match
+  static uint64_t next_id() {
+    static std::atomic<uint64_t> next{1};
+    return next.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // The calling thread's slot for this cache
+  Entry &slot() const {
+    thread_local std::array<Entry, n_slots> slots;
+    return slots[m_id % n_slots];
+  }
+
+  bool matches(const Entry &entry, const xt::xarray<ScalarType> &x) const {
+    if (entry.owner != m_id
+        || entry.epoch != m_epoch.load(std::memory_order_relaxed)
+        || x.size() != entry.point.size()) {
+      return false;
+    }
+    const ScalarType tol = this->tolerance();
+    auto pit             = entry.point.cbegin();
+    for (auto xit = x.cbegin(); xit != x.cend(); ++xit, ++pit) {
+      // Written so that a NaN on either side is never a match
+      if (!(std::abs(*xit - *pit) <= tol)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  const Entry *lookup(const xt::xarray<ScalarType> &x) const {
+    if (!this->enabled()) {
+      return nullptr;
+    }
+    const Entry &entry = this->slot();
+    return this->matches(entry, x) ? &entry : nullptr;
+  }
+
+  // This thread's entry moved to x if needed, null when caching is disabled
+  Entry *rebase(const xt::xarray<ScalarType> &x) {
+    if (!this->enabled()) {
+      return nullptr;
+    }
+    Entry &entry = this->slot();
+    if (!this->matches(entry, x)) {
+      entry.owner = m_id;
+      entry.epoch = m_epoch.load(std::memory_order_relaxed);
+      entry.point = x;
+      entry.value.reset();
+      entry.gradient.reset();
+      entry.hessian.reset();
+    }
+    return &entry;
+  }
+};
+
+} // namespace func
+} // namespace xts
@@ -0,0 +1,391 @@
+#pragma once
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "xtensor/xarray.hpp"
+#include "xtensor/xbuilder.hpp"
+#include "xtensor/xnoalias.hpp"
+#include "xtensor/xtensor.hpp"
+#include "xtensor/xview.hpp"
+
+#include "xtsci/func/base.hpp"
+
+namespace xts {
+namespace func {
+
+template <typename ScalarType>
+using FunctionPtr = std::shared_ptr<const ObjectiveFunction<ScalarType>>;
+
+// Penalty on single coordinates, summed over dofs with d = x_j - center_j.
+// Harmonic is k/2 d^2, flat bottom is zero for |d| <= radius and
+// k/2 (|d| - radius)^2 beyond.
+template <typename ScalarType> struct Restraint {
+  enum class Kind { harmonic, flat_bottom };
+
+  Kind kind = Kind::harmonic;
+  std::vector<size_t> dofs;
+  std::vector<ScalarType> centers;
+  ScalarType k      = 0;
+  ScalarType radius = 0;
+
+  // Energy, first and second derivative along a coordinate at offset d
+  std::tuple<ScalarType, ScalarType, ScalarType>
+  terms(ScalarType offset) const {
+    ScalarType excess = offset;
+    if (kind == Kind::flat_bottom) {
+      const ScalarType outside = std::abs(offset) - radius;
+      if (outside <= 0) {
+        return {0, 0, 0};
+      }
+      excess = std::copysign(outside, offset);
+    }
+    return {k * excess * excess / 2, k * excess, k};
+  }
+};
+
+template <typename ScalarType>
+Restraint<ScalarType> harmonic_restraint(
+    std::vector<size_t> dofs, std::vector<ScalarType> centers, ScalarType k) {
+  return {
+      Restraint<ScalarType>::Kind::harmonic, std::move(dofs),
+      std::move(centers), k, 0};
+}
+
+template <typename ScalarType>
+Restraint<ScalarType> flat_bottom_restraint(
+    std::vector<size_t> dofs, std::vector<ScalarType> centers, ScalarType k,
+    ScalarType radius) {
+  return {
+      Restraint<ScalarType>::Kind::flat_bottom, std::move(dofs),
+      std::move(centers), k, radius};
+}
+
+// sum_i w_i f_i(x - s_i) + restraints + offset, built with compose(f), +, -,
+// scalar *, shifted and restrained. Building only rearranges the flat term
+// list, nothing is evaluated until the composite is. An evaluation then makes
+// one value_and_gradient (or batch) call per term through the term's public
+// API, so its caches and evaluation counts see every call, and accumulates
+// into a single result; restraints are added in place, without arrays.
+template <typename ScalarType = double>
+class Composite : public ObjectiveFunction<ScalarType> {
+public:
+  struct Term {
+    FunctionPtr<ScalarType> func;
+    ScalarType weight = 1;
+    // Evaluated at x - shift when set
+    std::optional<xt::xarray<ScalarType>> shift;
+  };
+
+  explicit Composite(FunctionPtr<ScalarType> func)
+      : ObjectiveFunction<ScalarType>(func->m_isFixed.size(), func->m_isFixed),
+        m_terms{Term{std::move(func), 1, std::nullopt}} {}
+
+  const std::vector<Term> &terms() const { return m_terms; }
+  const std::vector<Restraint<ScalarType>> &restraints() const {
+    return m_restraints;
+  }
+  ScalarType offset() const { return m_offset; }
+  // Terms share their dimensions, so the first one speaks for all
+  bool points_are_free() const override {
+    return m_terms.front().func->points_are_free();
+  }
+
+  // g(x) = f(x - x0), restraint centers move along
+  Composite shifted(const xt::xarray<ScalarType> &x0) const {
+    Composite result(*this);
+    for (auto &term : result.m_terms) {
+      term.shift = term.shift ? xt::xarray<ScalarType>(*term.shift + x0) : x0;
+    }
+    for (auto &restraint : result.m_restraints) {
+      for (size_t idx = 0; idx < restraint.dofs.size(); ++idx) {
+        restraint.centers[idx] += x0.flat(restraint.dofs[idx]);
+      }
+    }
+    result.clear_cache();
+    return result;
+  }
+
+  Composite restrained(Restraint<ScalarType> restraint) const {
+    if (restraint.dofs.size() != restraint.centers.size()) {
+      throw std::invalid_argument("A restraint needs one center per dof.");
+    }
+    Composite result(*this);
+    result.m_restraints.push_back(std::move(restraint));
+    result.clear_cache();
+    return result;
+  }
+
+  Composite &operator+=(const Composite &other) {
+    if (other.m_isFixed.size() != this->m_isFixed.size()) {
+      throw std::invalid_argument("Composite terms differ in dimension.");
+    }
+    m_terms.insert(m_terms.end(), other.m_terms.begin(), other.m_terms.end());
+    m_restraints.insert(
+        m_restraints.end(), other.m_restraints.begin(),
+        other.m_restraints.end());
+    m_offset += other.m_offset;
+    this->clear_cache();
+    return *this;
+  }
+
+  Composite &operator+=(ScalarType bias) {
+    m_offset += bias;
+    this->clear_cache();
+    return *this;
+  }
+
+  Composite &operator*=(ScalarType factor) {
+    for (auto &term : m_terms) {
+      term.weight *= factor;
+    }
+    for (auto &restraint : m_restraints) {
+      restraint.k *= factor;
+    }
+    m_offset *= factor;
+    this->clear_cache();
+    return *this;
+  }
+
+private:
+  std::vector<Term> m_terms;
+  std::vector<Restraint<ScalarType>> m_restraints;
+  ScalarType m_offset = 0;
+
+  // Runs fn(term, point) with the point the term is evaluated at, copying
+  // only for shifted terms
+  template <class Fn>
+  void for_terms(const xt::xarray<ScalarType> &x, Fn &&fn) const {
+    for (const auto &term : m_terms) {
+      if (term.shift) {
+        fn(term, xt::xarray<ScalarType>(x - *term.shift));
+      } else {
+        fn(term, x);
+      }
+    }
+  }
+
+  template <class Fn>
+  void for_terms(const xt::xtensor<ScalarType, 2> &pts, Fn &&fn) const {
+    for (const auto &term : m_terms) {
+      if (term.shift) {
+        const auto shift = xt::reshape_view(
+            *term.shift, std::array<size_t, 2>{1, term.shift->size()});
+        fn(term, xt::xtensor<ScalarType, 2>(pts - shift));
+      } else {
+        fn(term, pts);
+      }
+    }
+  }
+
+  // Offset and restraint energy at the contiguous point x, with the gradient
+  // added into grad when given
+  ScalarType restrain(const ScalarType *x, ScalarType *grad = nullptr) const {
+    ScalarType energy = m_offset;
+    for (const auto &restraint : m_restraints) {
+      for (size_t idx = 0; idx < restraint.dofs.size(); ++idx) {
+        const size_t dof = restraint.dofs[idx];
+        const auto [e_val, g_val, h_val]
+            = restraint.terms(x[dof] - restraint.centers[idx]);
+        energy += e_val;
+        if (grad != nullptr) {
+          grad[dof] += g_val;
+        }
+      }
+    }
+    return energy;
+  }
+
+  ScalarType compute(const xt::xarray<ScalarType> &x) const override {
+    ScalarType fval = this->restrain(x.data());
+    this->for_terms(x, [&](const Term &term, const auto &point) {
+      fval += term.weight * (*term.func)(point);
+    });
+    return fval;
+  }
+
+  std::pair<ScalarType, std::optional<xt::xarray<ScalarType>>>
+  compute_value_and_gradient(const xt::xarray<ScalarType> &x) const override {
+    xt::xarray<ScalarType> grad = xt::zeros<ScalarType>(x.shape());
+    ScalarType fval             = this->restrain(x.data(), grad.data());
+    bool complete               = true;
+    this->for_terms(x, [&](const Term &term, const auto &point) {
+      auto [t_val, t_grad] = term.func->value_and_gradient(point);
+      fval += term.weight * t_val;
+      if (!t_grad) {
+        complete = false;
+      } else if (complete) {
+        xt::noalias(grad) += term.weight * *t_grad;
+      }
+    });
+    if (!complete) {
+      return {fval, std::nullopt};
+    }
+    return {fval, std::move(grad)};
+  }
+
+  std::optional<xt::xarray<ScalarType>>
+  compute_gradient(const xt::xarray<ScalarType> &x) const override {
+    return this->compute_value_and_gradient(x).second;
+  }
+
+  std::optional<xt::xarray<ScalarType>>
+  compute_hessian(const xt::xarray<ScalarType> &x) const override {
+    const size_t ndim           = x.size();
+    xt::xarray<ScalarType> hess = xt::zeros<ScalarType>({ndim, ndim});
+    bool complete               = true;
+    this->for_terms(x, [&](const Term &term, const auto &point) {
+      if (!complete) {
+        return;
+      }
+      auto t_hess = term.func->hessian(point);
+      if (!t_hess) {
+        complete = false;
+        return;
+      }
+      xt::noalias(hess) += term.weight * *t_hess;
+    });
+    if (!complete) {
+      return std::nullopt;
+    }
+    for (const auto &restraint : m_restraints) {
+      for (size_t idx = 0; idx < restraint.dofs.size(); ++idx) {
+        const size_t dof = restraint.dofs[idx];
+        hess(dof, dof) += std::get<2>(
+            restraint.terms(x.flat(dof) - restraint.centers[idx]));
+      }
+    }
+    return hess;
+  }
+
+  std::optional<xt::xtensor<ScalarType, 2>> compute_hessian_matrix_product(
+      const xt::xarray<ScalarType> &x,
+      const xt::xtensor<ScalarType, 2> &dirs) const override {
+    xt::xtensor<ScalarType, 2> prod = xt::zeros<ScalarType>(dirs.shape());
+    bool complete                   = true;
+    this->for_terms(x, [&](const Term &term, const auto &point) {
+      if (!complete) {
+        return;
+      }
+      auto t_prod = term.func->hessian_matrix_product(point, dirs);
+      if (!t_prod) {
+        complete = false;
+        return;
+      }
+      xt::noalias(prod) += term.weight * *t_prod;
+    });
+    if (!complete) {
+      return std::nullopt;
+    }
+    // The restraint Hessian is diagonal, so it scales rows of dirs
+    for (const auto &restraint : m_restraints) {
+      for (size_t idx = 0; idx < restraint.dofs.size(); ++idx) {
+        const size_t dof           = restraint.dofs[idx];
+        const ScalarType curvature = std::get<2>(
+            restraint.terms(x.flat(dof) - restraint.centers[idx]));
+        xt::row(prod, dof) += curvature * xt::row(dirs, dof);
+      }
+    }
+    return prod;
+  }
+
+  xt::xtensor<ScalarType, 1>
+  compute_batch(const xt::xtensor<ScalarType, 2> &pts) const override {
+    const size_t npts               = pts.shape(0);
+    xt::xtensor<ScalarType, 1> vals = xt::empty<ScalarType>({npts});
+    for (size_t row = 0; row < npts; ++row) {
+      vals(row) = this->restrain(&pts(row, 0));
+    }
+    this->for_terms(pts, [&](const Term &term, const auto &points) {
+      xt::noalias(vals) += term.weight * term.func->evaluate_batch(points);
+    });
+    return vals;
+  }
+
+  std::pair<
+      xt::xtensor<ScalarType, 1>, std::optional<xt::xtensor<ScalarType, 2>>>
+  compute_value_and_gradient_batch(
+      const xt::xtensor<ScalarType, 2> &pts) const override {
+    const size_t npts                = pts.shape(0);
+    const size_t ndim                = pts.shape(1);
+    xt::xtensor<ScalarType, 1> vals  = xt::empty<ScalarType>({npts});
+    xt::xtensor<ScalarType, 2> grads = xt::zeros<ScalarType>({npts, ndim});
+    for (size_t row = 0; row < npts; ++row) {
+      vals(row) = this->restrain(&pts(row, 0), &grads(row, 0));
+    }
+    bool complete = true;
+    this->for_terms(pts, [&](const Term &term, const auto &points) {
+      auto [t_vals, t_grads] = term.func->value_and_gradient_batch(points);
+      xt::noalias(vals) += term.weight * t_vals;
+      if (!t_grads) {
+        complete = false;
+      } else if (complete) {
+        xt::noalias(grads) += term.weight * *t_grads;
+      }
+    });
+    if (!complete) {
+      return {std::move(vals), std::nullopt};
+    }
+    return {std::move(vals), std::move(grads)};
+  }
+
+  std::optional<xt::xtensor<ScalarType, 2>>
+  compute_gradient_batch(const xt::xtensor<ScalarType, 2> &pts) const override {
+    return this->compute_value_and_gradient_batch(pts).second;
+  }
+};
+
+// Any shared ObjectiveFunction, e.g. std::make_shared<MullerBrown<>>()
+template <class Func>
+Composite<typename Func::scalar_type> compose(std::shared_ptr<Func> func) {
+  using ScalarType = typename Func::scalar_type;
+  return Composite<ScalarType>(FunctionPtr<ScalarType>(std::move(func)));
+}
+
+template <typename ScalarType>
+Composite<ScalarType>
+operator+(Composite<ScalarType> lhs, const Composite<ScalarType> &rhs) {
+  lhs += rhs;
+  return lhs;
+}
+
+template <typename ScalarType>
+Composite<ScalarType>
+operator-(Composite<ScalarType> lhs, Composite<ScalarType> rhs) {
+  rhs *= ScalarType{-1};
+  lhs += rhs;
+  return lhs;
+}
+
+template <typename ScalarType>
+Composite<ScalarType>
+operator+(Composite<ScalarType> lhs, std::type_identity_t<ScalarType> bias) {
+  lhs += bias;
+  return lhs;
+}
+
+template <typename ScalarType>
+Composite<ScalarType>
+operator*(std::type_identity_t<ScalarType> factor, Composite<ScalarType> rhs) {
+  rhs *= factor;
+  return rhs;
+}
+
+template <typename ScalarType>
+Composite<ScalarType>
+operator*(Composite<ScalarType> lhs, std::type_identity_t<ScalarType> factor) {
+  lhs *= factor;
+  return lhs;
+}
+
+} // namespace func
+} // namespace xts
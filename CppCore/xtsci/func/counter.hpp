@@ -0,0 +1,140 @@
+#pragma once
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace xts {
+namespace func {
+
+struct EvaluationCounter {
+  size_t function_evals        = 0;
+  size_t gradient_evals        = 0;
+  size_t hessian_evals         = 0;
+  size_t unique_func_grad_hess = 0; // Calls which were actually computed
+  size_t cache_hits            = 0;
+  size_t cache_misses          = 0;
+
+  EvaluationCounter &operator+=(const EvaluationCounter &other) {
+    function_evals += other.function_evals;
+    gradient_evals += other.gradient_evals;
+    hessian_evals += other.hessian_evals;
+    unique_func_grad_hess += other.unique_func_grad_hess;
+    cache_hits += other.cache_hits;
+    cache_misses += other.cache_misses;
+    return *this;
+  }
+
+  // For per-phase measurements, later - earlier
+  EvaluationCounter operator-(const EvaluationCounter &earlier) const {
+    EvaluationCounter delta;
+    delta.function_evals        = function_evals - earlier.function_evals;
+    delta.gradient_evals        = gradient_evals - earlier.gradient_evals;
+    delta.hessian_evals         = hessian_evals - earlier.hessian_evals;
+    delta.unique_func_grad_hess = unique_func_grad_hess
+                                  - earlier.unique_func_grad_hess;
+    delta.cache_hits   = cache_hits - earlier.cache_hits;
+    delta.cache_misses = cache_misses - earlier.cache_misses;
+    return delta;
+  }
+
+  bool operator==(const EvaluationCounter &) const = default;
+};
+
+enum class CounterField : size_t {
+  function_evals = 0,
+  gradient_evals,
+  hessian_evals,
+  unique_func_grad_hess,
+  cache_hits,
+  cache_misses,
+  n_fields
+};
+
+// Lock free EvaluationCounter, increments land on a per-thread shard (relaxed
+// atomics on their own cache line) and reads sum over the shards. Threads are
+// assigned shards round robin, so beyond n_shards threads they are shared,
+// which is still correct, just slower.
+// NOTE: Copies start from the summed counts of the source
+class ShardedCounter {
+public:
+  static constexpr size_t n_shards = 32;
+
+  ShardedCounter() = default;
+  ShardedCounter(const ShardedCounter &other) { this->load(other.snapshot()); }
+  ShardedCounter &operator=(const ShardedCounter &other) {
+    if (this != &other) {
+      this->load(other.snapshot());
+    }
+    return *this;
+  }
+
+  void add(CounterField field, size_t count = 1) {
+    m_shards[shard_index()]
+        .vals[static_cast<size_t>(field)]
+        .fetch_add(count, std::memory_order_relaxed);
+  }
+
+  EvaluationCounter snapshot() const {
+    std::array<size_t, n_fields> sums{};
+    for (const auto &shard : m_shards) {
+      for (size_t idx = 0; idx < n_fields; ++idx) {
+        sums[idx] += shard.vals[idx].load(std::memory_order_relaxed);
+      }
+    }
+    EvaluationCounter counts;
+    counts.function_evals        = sums[field(CounterField::function_evals)];
+    counts.gradient_evals        = sums[field(CounterField::gradient_evals)];
+    counts.hessian_evals         = sums[field(CounterField::hessian_evals)];
+    counts.unique_func_grad_hess = sums[field(
+        CounterField::unique_func_grad_hess)];
+    counts.cache_hits   = sums[field(CounterField::cache_hits)];
+    counts.cache_misses = sums[field(CounterField::cache_misses)];
+    return counts;
+  }
+
+  // Increments racing with a reset may or may not survive it
+  void reset() {
+    for (auto &shard : m_shards) {
+      for (auto &val : shard.vals) {
+        val.store(0, std::memory_order_relaxed);
+      }
+    }
+  }
+
+private:
+  static constexpr size_t n_fields
+      = static_cast<size_t>(CounterField::n_fields);
+
+  struct alignas(64) Shard {
+    std::array<std::atomic<size_t>, n_fields> vals{};
+  };
+  std::array<Shard, n_shards> m_shards{};
+
+  static constexpr size_t field(CounterField which) {
+    return static_cast<size_t>(which);
+  }
+
+  static size_t shard_index() {
+    static std::atomic<size_t> next_slot{0};
+    thread_local const size_t slot
+        = next_slot.fetch_add(1, std::memory_order_relaxed) % n_shards;
+    return slot;
+  }
+
+  void load(const EvaluationCounter &counts) {
+    this->reset();
+    auto &vals = m_shards[0].vals;
+    vals[field(CounterField::function_evals)].store(counts.function_evals);
+    vals[field(CounterField::gradient_evals)].store(counts.gradient_evals);
+    vals[field(CounterField::hessian_evals)].store(counts.hessian_evals);
+    vals[field(CounterField::unique_func_grad_hess)].store(
+        counts.unique_func_grad_hess);
+    vals[field(CounterField::cache_hits)].store(counts.cache_hits);
+    vals[field(CounterField::cache_misses)].store(counts.cache_misses);
+  }
+};
+
+} // namespace func
+} // namespace xts
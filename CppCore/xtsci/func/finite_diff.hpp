@@ -0,0 +1,252 @@
+#pragma once
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "xtensor/xarray.hpp"
+#include "xtensor/xbuilder.hpp"
+#include "xtensor/xmath.hpp"
+#include "xtensor/xtensor.hpp"
+#include "xtensor/xview.hpp"
+
+namespace xts {
+namespace func {
+
+// Finite difference derivatives, used by ObjectiveFunction when a subclass
+// has no analytic gradient or Hessian. Gradients difference function values,
+// Hessian columns difference gradients. All displaced points of a derivative
+// are laid out as one batch (see Probes), which ObjectiveFunction evaluates in
+// blocks spread over threads; the batch hooks must therefore be safe to call
+// concurrently.
+
+enum class FDStencil {
+  forward,   // (f(x + h) - f(x)) / h, O(h)
+  central,   // (f(x + h) - f(x - h)) / 2h, O(h^2)
+  five_point // O(h^4), four evaluations per coordinate
+};
+
+template <typename ScalarType> struct FDOptions {
+  FDStencil stencil = FDStencil::central;
+  // Absolute step, zero picks eps^(1/(order + 1)) * max(1, |x_j|)
+  ScalarType step  = 0;
+  size_t n_threads = 0; // Zero means one per hardware thread
+};
+
+namespace fd {
+
+// Evaluations per differenced coordinate
+inline size_t n_probes(FDStencil stencil) {
+  switch (stencil) {
+  case FDStencil::forward:
+    return 1;
+  case FDStencil::central:
+    return 2;
+  case FDStencil::five_point:
+    return 4;
+  }
+  return 2;
+}
+
+// Evaluations for one derivative over n_dofs coordinates, forward differences
+// also need the undisplaced point
+inline size_t n_evaluations(FDStencil stencil, size_t n_dofs) {
+  return n_dofs * n_probes(stencil) + (stencil == FDStencil::forward ? 1 : 0);
+}
+
+template <typename ScalarType>
+ScalarType step_size(const FDOptions<ScalarType> &opts, ScalarType x_j) {
+  if (opts.step > 0) {
+    return opts.step;
+  }
+  const ScalarType eps = std::numeric_limits<ScalarType>::epsilon();
+  ScalarType rel       = std::cbrt(eps);
+  if (opts.stencil == FDStencil::forward) {
+    rel = std::sqrt(eps);
+  } else if (opts.stencil == FDStencil::five_point) {
+    rel = std::pow(eps, ScalarType{0.2});
+  }
+  return rel * std::max(ScalarType{1}, std::abs(x_j));
+}
+
+// Probe offsets of the stencil, in steps, in the order combine reads them
+inline std::vector<int> stencil_offsets(FDStencil stencil) {
+  switch (stencil) {
+  case FDStencil::forward:
+    return {1};
+  case FDStencil::central:
+    return {1, -1};
+  case FDStencil::five_point:
+    return {-2, -1, 1, 2};
+  }
+  return {1, -1};
+}
+
+// The stencil applied to probes at(k), k following stencil_offsets. at_x, the
+// probe at the undisplaced point, is only read by the forward stencil. Works
+// for scalar and array valued probes.
+template <typename ScalarType, class At, class Result>
+Result combine(
+    FDStencil stencil, At &&at, ScalarType step, const Result &at_x) {
+  switch (stencil) {
+  case FDStencil::forward:
+    return (at(0) - at_x) / step;
+  case FDStencil::central:
+    break;
+  case FDStencil::five_point:
+    return (at(0) - 8 * at(1) + 8 * at(2) - at(3)) / (12 * step);
+  }
+  return (at(0) - at(1)) / (2 * step);
+}
+
+// Every displaced point of a set of differences as the rows of one batch, so
+// that the probes are a single batched call (XTPot spreads those over its
+// workers). Difference task t owns rows [t * per_task, (t + 1) * per_task);
+// with with_x the undisplaced point is the last row.
+template <typename ScalarType> struct Probes {
+  xt::xtensor<ScalarType, 2> points;
+  std::vector<ScalarType> steps;
+  size_t per_task;
+
+  size_t n_tasks() const { return steps.size(); }
+  size_t row(size_t task, size_t probe) const {
+    return task * per_task + probe;
+  }
+};
+
+// Probes displacing one coordinate of dofs per task
+template <typename ScalarType>
+Probes<ScalarType> coordinate_probes(
+    const xt::xarray<ScalarType> &x, const std::vector<size_t> &dofs,
+    const FDOptions<ScalarType> &opts, bool with_x) {
+  const auto offsets = stencil_offsets(opts.stencil);
+  const size_t ndim  = x.size();
+  Probes<ScalarType> probes;
+  probes.per_task = offsets.size();
+  probes.points   = xt::empty<ScalarType>(
+      {dofs.size() * offsets.size() + (with_x ? 1 : 0), ndim});
+  for (size_t row = 0; row < probes.points.shape(0); ++row) {
+    std::copy(x.cbegin(), x.cend(), &probes.points(row, 0));
+  }
+  probes.steps.reserve(dofs.size());
+  for (size_t task = 0; task < dofs.size(); ++task) {
+    const ScalarType x_j = x.flat(dofs[task]);
+    // Representable step, so that (x + h) - x == h exactly
+    const ScalarType step = (x_j + step_size(opts, x_j)) - x_j;
+    probes.steps.push_back(step);
+    for (size_t probe = 0; probe < offsets.size(); ++probe) {
+      probes.points(probes.row(task, probe), dofs[task])
+          = x_j + offsets[probe] * step;
+    }
+  }
+  return probes;
+}
+
+// Probes along the columns of dirs listed in cols, one task per column
+template <typename ScalarType>
+Probes<ScalarType> directional_probes(
+    const xt::xarray<ScalarType> &x, const xt::xtensor<ScalarType, 2> &dirs,
+    const std::vector<size_t> &cols, const FDOptions<ScalarType> &opts) {
+  const auto offsets = stencil_offsets(opts.stencil);
+  const size_t ndim  = x.size();
+  // The largest displaced coordinate moves by a coordinate step at the
+  // largest |x_j|, however many coordinates the direction touches
+  const ScalarType x_max = ndim == 0 ? 0 : xt::amax(xt::abs(x))();
+  Probes<ScalarType> probes;
+  probes.per_task = offsets.size();
+  probes.points   = xt::empty<ScalarType>({cols.size() * offsets.size(), ndim});
+  probes.steps.reserve(cols.size());
+  for (size_t task = 0; task < cols.size(); ++task) {
+    const auto direction = xt::view(dirs, xt::all(), cols[task]);
+    const ScalarType step
+        = step_size(opts, x_max) / xt::amax(xt::abs(direction))();
+    probes.steps.push_back(step);
+    for (size_t probe = 0; probe < offsets.size(); ++probe) {
+      const size_t row = probes.row(task, probe);
+      for (size_t idx = 0; idx < ndim; ++idx) {
+        probes.points(row, idx)
+            = x.flat(idx) + offsets[probe] * step * direction(idx);
+      }
+    }
+  }
+  return probes;
+}
+
+// Gradient from the values at coordinate_probes(x, dofs, opts, forward), the
+// components outside dofs are zero
+template <typename ScalarType>
+xt::xarray<ScalarType> gradient(
+    const xt::xtensor<ScalarType, 1> &values, const Probes<ScalarType> &probes,
+    const xt::xarray<ScalarType> &x, const std::vector<size_t> &dofs,
+    const FDOptions<ScalarType> &opts) {
+  xt::xarray<ScalarType> grad = xt::zeros<ScalarType>(x.shape());
+  const ScalarType f_x
+      = opts.stencil == FDStencil::forward ? values(values.size() - 1) : 0;
+  for (size_t task = 0; task < dofs.size(); ++task) {
+    grad.flat(dofs[task]) = combine(
+        opts.stencil,
+        [&](size_t probe) { return values(probes.row(task, probe)); },
+        probes.steps[task], f_x);
+  }
+  return grad;
+}
+
+// Differences of the probe gradient rows for each task, as the columns of a
+// (ndim, n_tasks) matrix. at_x is the gradient at x, read by forward only.
+template <typename ScalarType>
+xt::xtensor<ScalarType, 2> gradient_differences(
+    const xt::xtensor<ScalarType, 2> &grads, const Probes<ScalarType> &probes,
+    const xt::xtensor<ScalarType, 1> &at_x, FDStencil stencil) {
+  const size_t ndim               = grads.shape(1);
+  xt::xtensor<ScalarType, 2> cols = xt::empty<ScalarType>(
+      {ndim, probes.n_tasks()});
+  for (size_t task = 0; task < probes.n_tasks(); ++task) {
+    const xt::xtensor<ScalarType, 1> column = combine(
+        stencil,
+        [&](size_t probe) {
+          return xt::xtensor<ScalarType, 1>(
+              xt::row(grads, probes.row(task, probe)));
+        },
+        probes.steps[task], at_x);
+    xt::view(cols, xt::all(), task) = column;
+  }
+  return cols;
+}
+
+// Hessian from the gradients at coordinate_probes(x, dofs, opts, forward),
+// symmetrised. Rows and columns outside dofs are zero.
+template <typename ScalarType>
+xt::xarray<ScalarType> hessian(
+    const xt::xtensor<ScalarType, 2> &grads, const Probes<ScalarType> &probes,
+    const xt::xarray<ScalarType> &x, const std::vector<size_t> &dofs,
+    const FDOptions<ScalarType> &opts) {
+  const size_t ndim               = x.size();
+  xt::xarray<ScalarType> hess     = xt::zeros<ScalarType>({ndim, ndim});
+  xt::xtensor<ScalarType, 1> at_x = xt::zeros<ScalarType>({ndim});
+  if (opts.stencil == FDStencil::forward) {
+    at_x = xt::row(grads, grads.shape(0) - 1);
+  }
+  const auto cols = gradient_differences(grads, probes, at_x, opts.stencil);
+  for (size_t task = 0; task < dofs.size(); ++task) {
+    for (size_t idx : dofs) {
+      hess(idx, dofs[task]) = cols(idx, task);
+    }
+  }
+  for (size_t adx = 0; adx < dofs.size(); ++adx) {
+    for (size_t bdx = adx + 1; bdx < dofs.size(); ++bdx) {
+      const size_t idx     = dofs[adx];
+      const size_t jdx     = dofs[bdx];
+      const ScalarType avg = (hess(idx, jdx) + hess(jdx, idx)) / 2;
+      hess(idx, jdx)       = avg;
+      hess(jdx, idx)       = avg;
+    }
+  }
+  return hess;
+}
+
+} // namespace fd
+} // namespace func
+} // namespace xts
@@ -0,0 +1,119 @@
+#pragma once
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+#include "xtensor/xfixed.hpp"
+#include "xtensor/xtensor.hpp"
+
+#include "xtsci/func/counter.hpp"
+
+namespace xts {
+namespace func {
+
+// Compile time dimension counterpart of ObjectiveFunction. Points, gradients
+// and Hessians are xtensor_fixed, so they live on the stack and a call never
+// touches the heap. There is no cache, this is meant for cheap functions in
+// tight loops; the dynamic ObjectiveFunction remains the general interface.
+template <typename ScalarType, std::size_t N> class FixedObjectiveFunction {
+public: // Types
+  static constexpr std::size_t dims = N;
+
+  using point_type    = xt::xtensor_fixed<ScalarType, xt::xshape<N>>;
+  using gradient_type = point_type;
+  using hessian_type  = xt::xtensor_fixed<ScalarType, xt::xshape<N, N>>;
+
+public: // Variables
+  xt::xtensor<ScalarType, 2> minima;
+  xt::xtensor<ScalarType, 2> saddles;
+  std::array<bool, N> m_isFixed{};
+
+public: // Constructors and destructor
+  FixedObjectiveFunction() = default;
+  explicit FixedObjectiveFunction(const std::array<bool, N> &isFixed)
+      : m_isFixed(isFixed) {}
+  virtual ~FixedObjectiveFunction() = default;
+
+public: // Functions and Operators
+  ScalarType operator()(const point_type &x) const {
+    m_counter.add(CounterField::function_evals);
+    m_counter.add(CounterField::unique_func_grad_hess);
+    return this->compute(x);
+  }
+
+  std::optional<gradient_type>
+  gradient(const point_type &x, const bool zero_fixed = false) const {
+    m_counter.add(CounterField::gradient_evals);
+    m_counter.add(CounterField::unique_func_grad_hess);
+    auto grad = this->compute_gradient(x);
+    if (grad && zero_fixed) {
+      for (std::size_t idx = 0; idx < N; ++idx) {
+        if (m_isFixed[idx]) {
+          (*grad)(idx) = 0;
+        }
+      }
+    }
+    return grad;
+  }
+
+  std::optional<hessian_type>
+  hessian(const point_type &x, const bool zero_fixed = false) const {
+    m_counter.add(CounterField::hessian_evals);
+    m_counter.add(CounterField::unique_func_grad_hess);
+    auto hess = this->compute_hessian(x);
+    if (hess && zero_fixed) {
+      for (std::size_t idx = 0; idx < N; ++idx) {
+        for (std::size_t jdx = 0; jdx < N; ++jdx) {
+          if (m_isFixed[idx] || m_isFixed[jdx]) {
+            (*hess)(idx, jdx) = 0;
+          }
+        }
+      }
+    }
+    return hess;
+  }
+
+  std::pair<ScalarType, std::optional<gradient_type>>
+  value_and_gradient(const point_type &x, const bool zero_fixed = false) const {
+    m_counter.add(CounterField::function_evals);
+    m_counter.add(CounterField::gradient_evals);
+    m_counter.add(CounterField::unique_func_grad_hess);
+    auto [fval, grad] = this->compute_value_and_gradient(x);
+    if (grad && zero_fixed) {
+      for (std::size_t idx = 0; idx < N; ++idx) {
+        if (m_isFixed[idx]) {
+          (*grad)(idx) = 0;
+        }
+      }
+    }
+    return {fval, grad};
+  }
+
+  EvaluationCounter evaluation_counts() const { return m_counter.snapshot(); }
+
+private:
+  mutable ShardedCounter m_counter;
+
+  virtual ScalarType compute(const point_type &x) const = 0;
+
+  virtual std::optional<gradient_type>
+  compute_gradient(const point_type &) const {
+    return std::nullopt;
+  }
+
+  virtual std::optional<hessian_type>
+  compute_hessian(const point_type &) const {
+    return std::nullopt;
+  }
+
+  virtual std::pair<ScalarType, std::optional<gradient_type>>
+  compute_value_and_gradient(const point_type &x) const {
+    return {this->compute(x), this->compute_gradient(x)};
+  }
+};
+
+} // namespace func
+} // namespace xts
@@ -0,0 +1,192 @@
+#pragma once
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "xtensor/xarray.hpp"
+#include "xtensor/xbuilder.hpp"
+#include "xtensor/xtensor.hpp"
+
+#include "xtsci/func/base.hpp"
+#include "xtsci/func/parallel.hpp"
+#include "xtsci/io/npy.hpp"
+
+namespace xts {
+namespace func {
+
+// One scanned coordinate, num points from start to stop (inclusive) along
+// dimension dim of the point
+template <typename ScalarType> struct AxisSpec {
+  size_t dim;
+  ScalarType start;
+  ScalarType stop;
+  size_t num;
+};
+
+template <typename ScalarType>
+std::vector<size_t> grid_shape(const std::vector<AxisSpec<ScalarType>> &axes) {
+  std::vector<size_t> shape;
+  shape.reserve(axes.size());
+  for (const auto &axis : axes) {
+    shape.push_back(axis.num);
+  }
+  return shape;
+}
+
+namespace detail {
+template <typename ScalarType>
+void check_axes(
+    const std::vector<AxisSpec<ScalarType>> &axes, size_t n_dims) {
+  if (axes.empty()) {
+    throw std::invalid_argument("Grid scans need at least one axis.");
+  }
+  std::vector<bool> seen(n_dims, false);
+  for (const auto &axis : axes) {
+    if (axis.dim >= n_dims) {
+      throw std::invalid_argument("Scanned dimension exceeds the base point.");
+    }
+    if (seen[axis.dim]) {
+      throw std::invalid_argument("Dimension scanned more than once.");
+    }
+    seen[axis.dim] = true;
+  }
+}
+} // namespace detail
+
+// Evaluates func over the tensor product of the axes, every other coordinate
+// pinned to base_point. Results are handed to sink(offset, values, count) in
+// C order (last axis fastest) and in increasing offset, so they can be
+// streamed straight to disk. Each worker keeps one (chunk_size, dims) batch
+// buffer filled with the base point, only the scanned coordinates are
+// rewritten per point.
+template <typename ScalarType, class Sink>
+void scan_gridND(
+    const ObjectiveFunction<ScalarType> &func,
+    const xt::xtensor<ScalarType, 1> &base_point,
+    const std::vector<AxisSpec<ScalarType>> &axes, Sink &&sink,
+    size_t n_threads = 0, size_t chunk_size = 1024) {
+  const size_t n_dims = base_point.size();
+  detail::check_axes(axes, n_dims);
+  const size_t n_axes = axes.size();
+  std::vector<xt::xtensor<ScalarType, 1>> axis_vals;
+  axis_vals.reserve(n_axes);
+  size_t n_points = 1;
+  for (const auto &axis : axes) {
+    axis_vals.emplace_back(
+        xt::linspace<ScalarType>(axis.start, axis.stop, axis.num));
+    n_points *= axis.num;
+  }
+  if (n_points == 0) {
+    return;
+  }
+
+  chunk_size             = std::max<size_t>(chunk_size, 1);
+  const size_t n_workers = parallel::resolve_threads(n_threads);
+  const size_t wave      = n_workers * chunk_size;
+  auto fill_base = [&base_point](xt::xtensor<ScalarType, 2> &pts) {
+    for (size_t row = 0; row < pts.shape(0); ++row) {
+      std::copy(base_point.cbegin(), base_point.cend(), &pts(row, 0));
+    }
+  };
+  std::vector<xt::xtensor<ScalarType, 2>> scratch(
+      n_workers, xt::xtensor<ScalarType, 2>(
+                     xt::empty<ScalarType>({chunk_size, n_dims})));
+  for (auto &pts : scratch) {
+    fill_base(pts);
+  }
+  std::vector<ScalarType> results(std::min(wave, n_points));
+
+  for (size_t wave0 = 0; wave0 < n_points; wave0 += wave) {
+    const size_t wave_len = std::min(wave, n_points - wave0);
+    const size_t n_chunks = (wave_len + chunk_size - 1) / chunk_size;
+    parallel::parallel_for(
+        n_chunks, n_threads, [&](size_t worker, size_t chunk) {
+          const size_t offset = wave0 + chunk * chunk_size;
+          const size_t count  = std::min(chunk_size, n_points - offset);
+          auto &pts           = scratch[worker];
+          if (pts.shape(0) != count) {
+            // Only the tail chunk has a different length
+            pts.resize({count, n_dims});
+            fill_base(pts);
+          }
+          // Unravel the first index, then step like an odometer
+          std::vector<size_t> index(n_axes);
+          size_t rest = offset;
+          for (size_t adx = n_axes; adx-- > 0;) {
+            index[adx] = rest % axes[adx].num;
+            rest /= axes[adx].num;
+          }
+          for (size_t row = 0; row < count; ++row) {
+            for (size_t adx = 0; adx < n_axes; ++adx) {
+              pts(row, axes[adx].dim) = axis_vals[adx](index[adx]);
+            }
+            for (size_t adx = n_axes; adx-- > 0;) {
+              if (++index[adx] < axes[adx].num) {
+                break;
+              }
+              index[adx] = 0;
+            }
+          }
+          auto vals = func.evaluate_batch(pts);
+          std::copy(
+              vals.cbegin(), vals.cend(),
+              results.begin() + static_cast<std::ptrdiff_t>(offset - wave0));
+        });
+    sink(wave0, static_cast<const ScalarType *>(results.data()), wave_len);
+  }
+}
+
+// In memory scan, shaped like the axes
+template <typename ScalarType>
+xt::xarray<ScalarType> eval_on_gridND(
+    const ObjectiveFunction<ScalarType> &func,
+    const xt::xtensor<ScalarType, 1> &base_point,
+    const std::vector<AxisSpec<ScalarType>> &axes, size_t n_threads = 0,
+    size_t chunk_size = 1024) {
+  xt::xarray<ScalarType> result = xt::empty<ScalarType>(grid_shape(axes));
+  scan_gridND(
+      func, base_point, axes,
+      [&result](size_t offset, const ScalarType *vals, size_t count) {
+        std::copy(vals, vals + count, result.data() + offset);
+      },
+      n_threads, chunk_size);
+  return result;
+}
+
+// Streams the scan into an npz holding "z" (shaped like the axes), the 1-D
+// "axis_<k>" values and the scanned "dims"
+template <typename ScalarType>
+void npz_on_gridND_stream(
+    const ObjectiveFunction<ScalarType> &func,
+    const xt::xtensor<ScalarType, 1> &base_point,
+    const std::vector<AxisSpec<ScalarType>> &axes,
+    const std::string &filename = "gridND.npz", size_t n_threads = 0,
+    size_t chunk_size = 1024) {
+  io::NpzStreamWriter npz(filename);
+  npz.begin_array<ScalarType>("z", grid_shape(axes));
+  scan_gridND(
+      func, base_point, axes,
+      [&npz](size_t, const ScalarType *vals, size_t count) {
+        npz.append(vals, count);
+      },
+      n_threads, chunk_size);
+  npz.end_array();
+  std::vector<uint64_t> dims;
+  for (size_t adx = 0; adx < axes.size(); ++adx) {
+    const xt::xtensor<ScalarType, 1> vals = xt::linspace<ScalarType>(
+        axes[adx].start, axes[adx].stop, axes[adx].num);
+    npz.write_array<ScalarType>(
+        "axis_" + std::to_string(adx), {vals.size()}, vals.data());
+    dims.push_back(axes[adx].dim);
+  }
+  npz.write_array<uint64_t>("dims", {dims.size()}, dims.data());
+  npz.close();
+}
+
+} // namespace func
+} // namespace xts
@@ -2,14 +2,22 @@
 // MIT License
 // Copyright 2023--present Rohit Goswami <HaoZeke>
 #include <algorithm>
+#include <array>
+#include <concepts>
 #include <functional>
 #include <limits>
 #include <optional>
 #include <string>
+#include <type_traits>
 #include <vector>
 
+#ifdef XTSCI_USE_XSIMD
+#include <xsimd/xsimd.hpp>
+#endif
+
 #include "xtensor-blas/xlinalg.hpp"
 #include "xtensor/xarray.hpp"
+#include "xtensor/xtensor.hpp"
 
 namespace xts {
 namespace func {
@@ -28,6 +36,125 @@ void ensure_normalized(
     }
   }
 }
+
+// Tight loops over (n_points, 2) batches for the static kernels of a D2
+// trial function, no per point allocations. With XTSCI_USE_XSIMD the kernels
+// are instantiated on xsimd batches so a full register of points is evaluated
+// per call, the remainder goes through the scalar instantiation.
+#ifdef XTSCI_USE_XSIMD
+template <typename ScalarType>
+concept SimdScalar
+    = std::is_same_v<ScalarType, float> || std::is_same_v<ScalarType, double>;
+
+template <class Trial, typename ScalarType>
+concept SimdValueKernel
+    = SimdScalar<ScalarType> && requires(xsimd::batch<ScalarType> val) {
+        {
+          Trial::value_kernel(val, val)
+        } -> std::convertible_to<xsimd::batch<ScalarType>>;
+      };
+
+template <class Trial, typename ScalarType>
+concept SimdGradientKernel
+    = SimdScalar<ScalarType> && requires(xsimd::batch<ScalarType> val) {
+        Trial::gradient_kernel(val, val);
+      };
+#endif
+
+template <class Trial, typename ScalarType>
+xt::xtensor<ScalarType, 1>
+batch_value2D(const xt::xtensor<ScalarType, 2> &pts) {
+  const size_t npts                 = pts.shape(0);
+  xt::xtensor<ScalarType, 1> result = xt::empty<ScalarType>({npts});
+  const ScalarType *xy              = pts.data();
+  ScalarType *out                   = result.data();
+  size_t idx                        = 0;
+#ifdef XTSCI_USE_XSIMD
+  if constexpr (SimdValueKernel<Trial, ScalarType>) {
+    using simd_type         = xsimd::batch<ScalarType>;
+    constexpr size_t nlanes = simd_type::size;
+    std::array<ScalarType, nlanes> x_lanes;
+    std::array<ScalarType, nlanes> y_lanes;
+    for (; idx + nlanes <= npts; idx += nlanes) {
+      for (size_t lane = 0; lane < nlanes; ++lane) {
+        x_lanes[lane] = xy[2 * (idx + lane)];
+        y_lanes[lane] = xy[2 * (idx + lane) + 1];
+      }
+      simd_type fval = Trial::value_kernel(
+          simd_type::load_unaligned(x_lanes.data()),
+          simd_type::load_unaligned(y_lanes.data()));
+      fval.store_unaligned(out + idx);
+    }
+  }
+#endif
+  for (; idx < npts; ++idx) {
+    out[idx] = Trial::value_kernel(xy[2 * idx], xy[2 * idx + 1]);
+  }
+  return result;
+}
+
+template <class Trial, typename ScalarType>
+xt::xtensor<ScalarType, 2>
+batch_gradient2D(const xt::xtensor<ScalarType, 2> &pts) {
+  const size_t npts                 = pts.shape(0);
+  xt::xtensor<ScalarType, 2> result = xt::empty<ScalarType>({npts, size_t{2}});
+  const ScalarType *xy              = pts.data();
+  ScalarType *out                   = result.data();
+  size_t idx                        = 0;
+#ifdef XTSCI_USE_XSIMD
+  if constexpr (SimdGradientKernel<Trial, ScalarType>) {
+    using simd_type         = xsimd::batch<ScalarType>;
+    constexpr size_t nlanes = simd_type::size;
+    std::array<ScalarType, nlanes> x_lanes;
+    std::array<ScalarType, nlanes> y_lanes;
+    for (; idx + nlanes <= npts; idx += nlanes) {
+      for (size_t lane = 0; lane < nlanes; ++lane) {
+        x_lanes[lane] = xy[2 * (idx + lane)];
+        y_lanes[lane] = xy[2 * (idx + lane) + 1];
+      }
+      auto [df_dx, df_dy] = Trial::gradient_kernel(
+          simd_type::load_unaligned(x_lanes.data()),
+          simd_type::load_unaligned(y_lanes.data()));
+      df_dx.store_unaligned(x_lanes.data());
+      df_dy.store_unaligned(y_lanes.data());
+      for (size_t lane = 0; lane < nlanes; ++lane) {
+        out[2 * (idx + lane)]     = x_lanes[lane];
+        out[2 * (idx + lane) + 1] = y_lanes[lane];
+      }
+    }
+  }
+#endif
+  for (; idx < npts; ++idx) {
+    auto [df_dx, df_dy] = Trial::gradient_kernel(xy[2 * idx], xy[2 * idx + 1]);
+    out[2 * idx]        = df_dx;
+    out[2 * idx + 1]    = df_dy;
+  }
+  return result;
+}
+
+// out[j] = f(x_val, y_vals[j]) for j < count, one row of a grid. The y values
+// are contiguous so no shuffling is needed for the SIMD loads.
+template <class Trial, typename ScalarType>
+void row_value2D(
+    ScalarType x_val, const ScalarType *y_vals, size_t count,
+    ScalarType *out) {
+  size_t jdx = 0;
+#ifdef XTSCI_USE_XSIMD
+  if constexpr (SimdValueKernel<Trial, ScalarType>) {
+    using simd_type         = xsimd::batch<ScalarType>;
+    constexpr size_t nlanes = simd_type::size;
+    const simd_type x_lanes(x_val);
+    for (; jdx + nlanes <= count; jdx += nlanes) {
+      simd_type fval = Trial::value_kernel(
+          x_lanes, simd_type::load_unaligned(y_vals + jdx));
+      fval.store_unaligned(out + jdx);
+    }
+  }
+#endif
+  for (; jdx < count; ++jdx) {
+    out[jdx] = Trial::value_kernel(x_val, y_vals[jdx]);
+  }
+}
 } // namespace helpers
 } // namespace func
 } // namespace xts
@@ -0,0 +1,118 @@
+#pragma once
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <utility>
+
+#include "xtensor/xarray.hpp"
+#include "xtensor/xtensor.hpp"
+
+#include "xtsci/func/base.hpp"
+
+namespace xts {
+namespace func {
+
+// Presents a ComputeType function as a StorageType one. Points are widened
+// on the way in and results narrowed on the way out, so a float grid or
+// training set moves half the bytes while every evaluation, and any sum
+// inside it, runs in ComputeType. The wrapped function keeps its own cache,
+// counters and finite difference settings.
+template <typename StorageType, typename ComputeType = double>
+class MixedPrecision : public ObjectiveFunction<StorageType> {
+public:
+  explicit MixedPrecision(
+      std::shared_ptr<const ObjectiveFunction<ComputeType>> inner)
+      : ObjectiveFunction<StorageType>(
+          inner->m_isFixed.size(), inner->m_isFixed),
+        m_inner(std::move(inner)) {
+    this->minima  = xt::cast<StorageType>(m_inner->minima);
+    this->saddles = xt::cast<StorageType>(m_inner->saddles);
+  }
+
+  const ObjectiveFunction<ComputeType> &inner() const { return *m_inner; }
+  bool points_are_free() const override { return m_inner->points_are_free(); }
+
+private:
+  std::shared_ptr<const ObjectiveFunction<ComputeType>> m_inner;
+
+  template <class E> static auto widen(const E &expr) {
+    return xt::eval(xt::cast<ComputeType>(expr));
+  }
+
+  template <class E>
+  static std::optional<xt::xarray<StorageType>>
+  narrow_array(const std::optional<E> &result) {
+    if (!result) {
+      return std::nullopt;
+    }
+    return xt::xarray<StorageType>(xt::cast<StorageType>(*result));
+  }
+
+  template <class E>
+  static std::optional<xt::xtensor<StorageType, 2>>
+  narrow_batch(const std::optional<E> &result) {
+    if (!result) {
+      return std::nullopt;
+    }
+    return xt::xtensor<StorageType, 2>(xt::cast<StorageType>(*result));
+  }
+
+  StorageType compute(const xt::xarray<StorageType> &x) const override {
+    return static_cast<StorageType>((*m_inner)(widen(x)));
+  }
+
+  std::optional<xt::xarray<StorageType>>
+  compute_gradient(const xt::xarray<StorageType> &x) const override {
+    return narrow_array(m_inner->gradient(widen(x)));
+  }
+
+  std::optional<xt::xarray<StorageType>>
+  compute_hessian(const xt::xarray<StorageType> &x) const override {
+    return narrow_array(m_inner->hessian(widen(x)));
+  }
+
+  std::pair<StorageType, std::optional<xt::xarray<StorageType>>>
+  compute_value_and_gradient(const xt::xarray<StorageType> &x) const override {
+    auto [fval, grad] = m_inner->value_and_gradient(widen(x));
+    return {static_cast<StorageType>(fval), narrow_array(grad)};
+  }
+
+  std::tuple<
+      StorageType, std::optional<xt::xarray<StorageType>>,
+      std::optional<xt::xarray<StorageType>>>
+  compute_value_gradient_hessian(
+      const xt::xarray<StorageType> &x) const override {
+    auto [fval, grad, hess] = m_inner->value_gradient_hessian(widen(x));
+    return {
+        static_cast<StorageType>(fval), narrow_array(grad), narrow_array(hess)};
+  }
+
+  xt::xtensor<StorageType, 1>
+  compute_batch(const xt::xtensor<StorageType, 2> &pts) const override {
+    return xt::cast<StorageType>(m_inner->evaluate_batch(widen(pts)));
+  }
+
+  std::optional<xt::xtensor<StorageType, 2>> compute_gradient_batch(
+      const xt::xtensor<StorageType, 2> &pts) const override {
+    return narrow_batch(m_inner->gradient_batch(widen(pts)));
+  }
+
+  std::pair<
+      xt::xtensor<StorageType, 1>, std::optional<xt::xtensor<StorageType, 2>>>
+  compute_value_and_gradient_batch(
+      const xt::xtensor<StorageType, 2> &pts) const override {
+    auto [vals, grads] = m_inner->value_and_gradient_batch(widen(pts));
+    return {xt::cast<StorageType>(vals), narrow_batch(grads)};
+  }
+
+  std::optional<xt::xtensor<StorageType, 2>> compute_hessian_matrix_product(
+      const xt::xarray<StorageType> &x,
+      const xt::xtensor<StorageType, 2> &dirs) const override {
+    return narrow_batch(m_inner->hessian_matrix_product(widen(x), widen(dirs)));
+  }
+};
+
+} // namespace func
+} // namespace xts
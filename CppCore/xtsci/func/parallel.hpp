@@ -0,0 +1,82 @@
+#pragma once
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace xts {
+namespace func {
+namespace parallel {
+
+// Zero means one thread per hardware thread
+inline size_t resolve_threads(size_t n_threads) {
+  if (n_threads == 0) {
+    n_threads = std::thread::hardware_concurrency();
+  }
+  return std::max<size_t>(n_threads, 1);
+}
+
+// Runs fn(worker, task) for every task in [0, n_tasks), tasks are handed out
+// dynamically to at most n_threads workers. Worker ids are dense in
+// [0, workers) so callers can keep per-worker scratch space. The first
+// exception thrown by any task is rethrown here once all workers stop.
+template <class Fn>
+void parallel_for(size_t n_tasks, size_t n_threads, Fn &&fn) {
+  const size_t n_workers = std::min(resolve_threads(n_threads), n_tasks);
+  if (n_workers <= 1) {
+    for (size_t task = 0; task < n_tasks; ++task) {
+      fn(size_t{0}, task);
+    }
+    return;
+  }
+
+  std::atomic<size_t> next_task{0};
+  std::atomic<bool> failed{false};
+  std::exception_ptr first_error;
+  std::mutex error_mutex;
+  auto worker_loop = [&](size_t worker) {
+    while (!failed.load(std::memory_order_relaxed)) {
+      const size_t task = next_task.fetch_add(1, std::memory_order_relaxed);
+      if (task >= n_tasks) {
+        return;
+      }
+      try {
+        fn(worker, task);
+      } catch (...) {
+        std::scoped_lock lock(error_mutex);
+        if (!first_error) {
+          first_error = std::current_exception();
+        }
+        failed.store(true, std::memory_order_relaxed);
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  workers.reserve(n_workers - 1);
+  for (size_t worker = 1; worker < n_workers; ++worker) {
+    workers.emplace_back(worker_loop, worker);
+  }
+  worker_loop(0);
+  for (auto &thread : workers) {
+    thread.join();
+  }
+  if (first_error) {
+    std::rethrow_exception(first_error);
+  }
+}
+
+// Number of workers parallel_for will actually use
+inline size_t n_workers(size_t n_tasks, size_t n_threads) {
+  return std::max<size_t>(
+      std::min(resolve_threads(n_threads), n_tasks), size_t{1});
+}
+
+} // namespace parallel
+} // namespace func
+} // namespace xts
@@ -0,0 +1,153 @@
+#pragma once
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+#include "xtensor-blas/xlinalg.hpp"
+#include "xtensor/xbuilder.hpp"
+#include "xtensor/xtensor.hpp"
+#include "xtensor/xview.hpp"
+
+#include "xtsci/func/base.hpp"
+
+namespace xts {
+namespace func {
+
+// Everything a chain of states method (NEB, string) needs per iteration, one
+// row per image
+template <typename ScalarType> struct PathEvaluation {
+  xt::xtensor<ScalarType, 1> energies;
+  xt::xtensor<ScalarType, 2> gradients;
+  // Unit tangents
+  xt::xtensor<ScalarType, 2> tangents;
+  // \nabla f \cdot \tau, e.g. for climbing images
+  xt::xtensor<ScalarType, 1> tangent_gradients;
+  // -(\nabla f - (\nabla f \cdot \tau) \tau)
+  xt::xtensor<ScalarType, 2> perpendicular_forces;
+};
+
+// Evaluates (n_images, dims) chains, grad_components for every image at
+// once. The images go to func as a single value_and_gradient_batch, so they
+// run concurrently wherever the batch does (packed kernels for the trial
+// functions, XTPot::enable_parallel_batches for potentials). With fixed
+// endpoints only the interior is evaluated; the endpoint energies, which the
+// tangents need, are computed once and reused while the endpoints stay put.
+// Their gradient, tangent and force rows are zero.
+template <typename ScalarType = double> class ChainEvaluator {
+public:
+  explicit ChainEvaluator(
+      const ObjectiveFunction<ScalarType> &func, bool fixed_endpoints = true)
+      : m_func(func), m_fixed_endpoints(fixed_endpoints) {}
+
+  PathEvaluation<ScalarType> evaluate(
+      const xt::xtensor<ScalarType, 2> &images,
+      const bool zero_fixed = false) const {
+    const size_t n_images = images.shape(0);
+    const size_t ndim     = images.shape(1);
+    if (n_images < 2) {
+      throw std::invalid_argument("A chain needs at least two images.");
+    }
+    PathEvaluation<ScalarType> path;
+    path.energies             = xt::zeros<ScalarType>({n_images});
+    path.gradients            = xt::zeros<ScalarType>({n_images, ndim});
+    path.tangents             = xt::zeros<ScalarType>({n_images, ndim});
+    path.tangent_gradients    = xt::zeros<ScalarType>({n_images});
+    path.perpendicular_forces = xt::zeros<ScalarType>({n_images, ndim});
+
+    const size_t first = m_fixed_endpoints ? 1 : 0;
+    const size_t last  = m_fixed_endpoints ? n_images - 1 : n_images;
+    if (first < last) {
+      const xt::xtensor<ScalarType, 2> moving
+          = xt::view(images, xt::range(first, last), xt::all());
+      auto [vals, grads] = m_func.value_and_gradient_batch(moving, zero_fixed);
+      if (!grads) {
+        throw std::runtime_error("Chain evaluation needs gradients.");
+      }
+      xt::view(path.energies, xt::range(first, last))             = vals;
+      xt::view(path.gradients, xt::range(first, last), xt::all()) = *grads;
+    }
+    if (m_fixed_endpoints) {
+      const auto [e_start, e_end] = this->endpoint_energies(images);
+      path.energies(0)            = e_start;
+      path.energies(n_images - 1) = e_end;
+    }
+
+    for (size_t idx = first; idx < last; ++idx) {
+      xt::xtensor<ScalarType, 1> tangent = this->tangent(images, path, idx);
+      const ScalarType norm              = xt::linalg::norm(tangent);
+      if (norm > 0) {
+        tangent /= norm;
+      }
+      auto grad           = xt::row(path.gradients, idx);
+      const ScalarType gt = xt::linalg::dot(grad, tangent)();
+
+      xt::row(path.tangents, idx)             = tangent;
+      path.tangent_gradients(idx)             = gt;
+      xt::row(path.perpendicular_forces, idx) = gt * tangent - grad;
+    }
+    return path;
+  }
+
+private:
+  const ObjectiveFunction<ScalarType> &m_func;
+  bool m_fixed_endpoints;
+  // Endpoints the energies below belong to
+  mutable xt::xtensor<ScalarType, 2> m_endpoints;
+  mutable std::pair<ScalarType, ScalarType> m_endpoint_energies;
+
+  std::pair<ScalarType, ScalarType>
+  endpoint_energies(const xt::xtensor<ScalarType, 2> &images) const {
+    const xt::xtensor<ScalarType, 2> ends
+        = xt::view(images, xt::keep(0, images.shape(0) - 1), xt::all());
+    if (m_endpoints.shape() != ends.shape() || m_endpoints != ends) {
+      const auto vals     = m_func.evaluate_batch(ends);
+      m_endpoints         = ends;
+      m_endpoint_energies = {vals(0), vals(1)};
+    }
+    return m_endpoint_energies;
+  }
+
+  // Upwind tangent (Henkelman and Jonsson, 2000) towards the higher energy
+  // neighbour, energy weighted at extrema so it turns smoothly. Endpoints
+  // use their only neighbour.
+  xt::xtensor<ScalarType, 1> tangent(
+      const xt::xtensor<ScalarType, 2> &images,
+      const PathEvaluation<ScalarType> &path, size_t idx) const {
+    const size_t n_images = images.shape(0);
+    if (idx == 0) {
+      return xt::row(images, 1) - xt::row(images, 0);
+    }
+    if (idx == n_images - 1) {
+      return xt::row(images, idx) - xt::row(images, idx - 1);
+    }
+    const xt::xtensor<ScalarType, 1> forward
+        = xt::row(images, idx + 1) - xt::row(images, idx);
+    const xt::xtensor<ScalarType, 1> backward
+        = xt::row(images, idx) - xt::row(images, idx - 1);
+    const ScalarType e_prev = path.energies(idx - 1);
+    const ScalarType e_here = path.energies(idx);
+    const ScalarType e_next = path.energies(idx + 1);
+    if (e_next > e_here && e_here > e_prev) {
+      return forward;
+    }
+    if (e_next < e_here && e_here < e_prev) {
+      return backward;
+    }
+    const ScalarType d_next = std::abs(e_next - e_here);
+    const ScalarType d_prev = std::abs(e_prev - e_here);
+    const ScalarType d_max  = std::max(d_next, d_prev);
+    const ScalarType d_min  = std::min(d_next, d_prev);
+    if (e_next > e_prev) {
+      return forward * d_max + backward * d_min;
+    }
+    return forward * d_min + backward * d_max;
+  }
+};
+
+} // namespace func
+} // namespace xts
@@ -2,6 +2,7 @@
 // MIT License
 // Copyright 2023--present Rohit Goswami <HaoZeke>
 #include <algorithm>
+#include <array>
 #include <functional>
 #include <limits>
 #include <optional>
@@ -14,7 +15,10 @@
 #include "xtensor/xarray.hpp"
 #include "xtensor/xvectorize.hpp"
 
+#include "xtsci/func/base.hpp"
 #include "xtsci/func/helpers.hpp"
+#include "xtsci/func/parallel.hpp"
+#include "xtsci/io/npy.hpp"
 
 namespace xts {
 namespace func {
@@ -45,5 +49,156 @@ void npz_on_grid2D(
   xt::dump_npz(filename, "x", x_mesh, true, true);
   xt::dump_npz(filename, "y", y_mesh, true, true);
 }
+
+namespace detail {
+// Evaluates rows [row_begin, row_end) of the grid into out, row-major with
+// out[(i - row_begin) * n_y + j] = f(x_i, y_j). Tiles of rows are handed to
+// the workers and each tile writes its own slice, so the result does not
+// depend on n_threads.
+template <typename ScalarType>
+void eval_grid_rows2D(
+    const xt::xtensor<ScalarType, 1> &x_line,
+    const xt::xtensor<ScalarType, 1> &y_line, size_t row_begin,
+    size_t row_end, const ObjectiveFunction<ScalarType> &func,
+    size_t n_threads, size_t tile_rows, ScalarType *out) {
+  const size_t n_y     = y_line.size();
+  tile_rows            = std::max<size_t>(tile_rows, 1);
+  const size_t n_tiles = (row_end - row_begin + tile_rows - 1) / tile_rows;
+  // One batch buffer per worker, reused across its tiles
+  std::vector<xt::xtensor<ScalarType, 2>> scratch(
+      parallel::n_workers(n_tiles, n_threads),
+      xt::xtensor<ScalarType, 2>(
+          xt::empty<ScalarType>({tile_rows * n_y, size_t{2}})));
+
+  parallel::parallel_for(n_tiles, n_threads, [&](size_t worker, size_t tile) {
+    const size_t row0 = row_begin + tile * tile_rows;
+    const size_t rows = std::min(tile_rows, row_end - row0);
+    auto &pts         = scratch[worker];
+    if (pts.shape(0) != rows * n_y) {
+      pts.resize({rows * n_y, size_t{2}});
+    }
+    for (size_t idx = 0; idx < rows; ++idx) {
+      for (size_t jdx = 0; jdx < n_y; ++jdx) {
+        pts(idx * n_y + jdx, 0) = x_line(row0 + idx);
+        pts(idx * n_y + jdx, 1) = y_line(jdx);
+      }
+    }
+    auto vals = func.evaluate_batch(pts);
+    std::copy(vals.cbegin(), vals.cend(), out + (row0 - row_begin) * n_y);
+  });
+}
+
+template <typename ScalarType>
+xt::xtensor<ScalarType, 1> grid_axis(const std::array<ScalarType, 3> &axis) {
+  return xt::linspace<ScalarType>(axis[0], axis[1], axis[2]);
+}
+} // namespace detail
+
+// Tiled, multi-threaded evaluation on an ObjectiveFunction through its batch
+// path, laid out like the meshgrid variant, z(i, j) = f(x_i, y_j). Zero
+// n_threads uses every hardware thread.
+template <typename ScalarType>
+xt::xtensor<ScalarType, 2> eval_on_grid2D(
+    const std::array<ScalarType, 3> &axOne,
+    const std::array<ScalarType, 3> &axTwo,
+    const ObjectiveFunction<ScalarType> &func, size_t n_threads = 0,
+    size_t tile_rows = 16) {
+  const auto x_line = detail::grid_axis(axOne);
+  const auto y_line = detail::grid_axis(axTwo);
+  xt::xtensor<ScalarType, 2> z_val
+      = xt::empty<ScalarType>({x_line.size(), y_line.size()});
+  detail::eval_grid_rows2D(
+      x_line, y_line, 0, x_line.size(), func, n_threads, tile_rows,
+      z_val.data());
+  return z_val;
+}
+
+template <typename ScalarType>
+void npz_on_grid2D(
+    const std::array<ScalarType, 3> &axOne,
+    const std::array<ScalarType, 3> &axTwo,
+    const ObjectiveFunction<ScalarType> &func,
+    std::string filename = "grid.npz", size_t n_threads = 0) {
+  auto z_val            = eval_on_grid2D(axOne, axTwo, func, n_threads);
+  auto [x_mesh, y_mesh] = xt::meshgrid(
+      detail::grid_axis(axOne), detail::grid_axis(axTwo));
+  xt::dump_npz(filename, "z", z_val, true, true);
+  xt::dump_npz(filename, "x", x_mesh, true, true);
+  xt::dump_npz(filename, "y", y_mesh, true, true);
+}
+
+// Memory bounded variant of npz_on_grid2D, blocks of block_rows rows are
+// evaluated and appended to the archive as they complete. With axes_only the
+// 1-D x and y axes are stored instead of the full meshes, which
+// scripts/plot_2d.py expands again. Archive entries are limited to 4 GiB,
+// npy_on_grid2D_stream has no such limit.
+template <typename ScalarType>
+void npz_on_grid2D_stream(
+    const std::array<ScalarType, 3> &axOne,
+    const std::array<ScalarType, 3> &axTwo,
+    const ObjectiveFunction<ScalarType> &func,
+    const std::string &filename = "grid.npz", bool axes_only = false,
+    size_t n_threads = 0, size_t block_rows = 256) {
+  const auto x_line = detail::grid_axis(axOne);
+  const auto y_line = detail::grid_axis(axTwo);
+  const size_t n_x  = x_line.size();
+  const size_t n_y  = y_line.size();
+  block_rows        = std::max<size_t>(block_rows, 1);
+  std::vector<ScalarType> block(std::min(block_rows, n_x) * n_y);
+
+  io::NpzStreamWriter npz(filename);
+  npz.begin_array<ScalarType>("z", {n_x, n_y});
+  for (size_t row0 = 0; row0 < n_x; row0 += block_rows) {
+    const size_t row1 = std::min(row0 + block_rows, n_x);
+    detail::eval_grid_rows2D(
+        x_line, y_line, row0, row1, func, n_threads, 16, block.data());
+    npz.append(block.data(), (row1 - row0) * n_y);
+  }
+  npz.end_array();
+
+  if (axes_only) {
+    npz.write_array<ScalarType>("x", {n_x}, x_line.data());
+    npz.write_array<ScalarType>("y", {n_y}, y_line.data());
+  } else {
+    // Same layout as xt::meshgrid, generated a block at a time
+    npz.begin_array<ScalarType>("x", {n_x, n_y});
+    for (size_t idx = 0; idx < n_x; ++idx) {
+      std::fill_n(block.begin(), n_y, x_line(idx));
+      npz.append(block.data(), n_y);
+    }
+    npz.end_array();
+    npz.begin_array<ScalarType>("y", {n_x, n_y});
+    for (size_t idx = 0; idx < n_x; ++idx) {
+      npz.append(y_line.data(), n_y);
+    }
+    npz.end_array();
+  }
+  npz.close();
+}
+
+// Streams only z, shaped (n_x, n_y), into a plain .npy file
+template <typename ScalarType>
+void npy_on_grid2D_stream(
+    const std::array<ScalarType, 3> &axOne,
+    const std::array<ScalarType, 3> &axTwo,
+    const ObjectiveFunction<ScalarType> &func,
+    const std::string &filename = "grid.npy", size_t n_threads = 0,
+    size_t block_rows = 256) {
+  const auto x_line = detail::grid_axis(axOne);
+  const auto y_line = detail::grid_axis(axTwo);
+  const size_t n_x  = x_line.size();
+  const size_t n_y  = y_line.size();
+  block_rows        = std::max<size_t>(block_rows, 1);
+  std::vector<ScalarType> block(std::min(block_rows, n_x) * n_y);
+
+  io::NpyStreamWriter<ScalarType> npy(filename, {n_x, n_y});
+  for (size_t row0 = 0; row0 < n_x; row0 += block_rows) {
+    const size_t row1 = std::min(row0 + block_rows, n_x);
+    detail::eval_grid_rows2D(
+        x_line, y_line, row0, row1, func, n_threads, 16, block.data());
+    npy.append(block.data(), (row1 - row0) * n_y);
+  }
+  npy.close();
+}
 } // namespace func
 } // namespace xts
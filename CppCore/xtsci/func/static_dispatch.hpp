@@ -0,0 +1,104 @@
+#pragma once
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "xtensor/xbuilder.hpp"
+#include "xtensor/xtensor.hpp"
+
+#include "xtsci/func/helpers.hpp"
+#include "xtsci/func/parallel.hpp"
+
+namespace xts {
+namespace func {
+
+// Static dispatch for functions whose concrete type is known at compile time.
+// The D2 trial functions satisfy these through their static kernels, so the
+// loops below call the kernels directly and the compiler is free to inline
+// and vectorise them. Nothing here touches the virtual interface, hence the
+// evaluation counters of an instance are not updated either.
+template <class F>
+concept StaticObjective2D = requires(typename F::scalar_type val) {
+  {
+    F::value_kernel(val, val)
+  } -> std::convertible_to<typename F::scalar_type>;
+};
+
+template <class F>
+concept StaticGradient2D
+    = StaticObjective2D<F> && requires(typename F::scalar_type val) {
+        {
+          F::gradient_kernel(val, val)
+        } -> std::convertible_to<std::array<typename F::scalar_type, 2>>;
+      };
+
+template <StaticObjective2D F>
+xt::xtensor<typename F::scalar_type, 1>
+static_evaluate_batch(const xt::xtensor<typename F::scalar_type, 2> &pts) {
+  return helpers::batch_value2D<F>(pts);
+}
+
+template <StaticGradient2D F>
+xt::xtensor<typename F::scalar_type, 2>
+static_gradient_batch(const xt::xtensor<typename F::scalar_type, 2> &pts) {
+  return helpers::batch_gradient2D<F>(pts);
+}
+
+// Same layout as eval_on_grid2D, z(i, j) = f(x_i, y_j), rows are split over
+// the threads without any intermediate point buffers
+template <StaticObjective2D F>
+xt::xtensor<typename F::scalar_type, 2> static_eval_on_grid2D(
+    const std::array<typename F::scalar_type, 3> &axOne,
+    const std::array<typename F::scalar_type, 3> &axTwo,
+    size_t n_threads = 0) {
+  using ScalarType = typename F::scalar_type;
+  const xt::xtensor<ScalarType, 1> x_line
+      = xt::linspace<ScalarType>(axOne[0], axOne[1], axOne[2]);
+  const xt::xtensor<ScalarType, 1> y_line
+      = xt::linspace<ScalarType>(axTwo[0], axTwo[1], axTwo[2]);
+  const size_t n_x = x_line.size();
+  const size_t n_y = y_line.size();
+  xt::xtensor<ScalarType, 2> z_val = xt::empty<ScalarType>({n_x, n_y});
+  parallel::parallel_for(n_x, n_threads, [&](size_t, size_t idx) {
+    helpers::row_value2D<F>(
+        x_line(idx), y_line.data(), n_y, z_val.data() + idx * n_y);
+  });
+  return z_val;
+}
+
+// Line search helpers, for every step length alpha evaluate
+// phi(alpha) = f(x0 + alpha d) and, when requested, phi'(alpha) = g . d
+template <StaticObjective2D F>
+std::vector<typename F::scalar_type> static_line_values(
+    const std::array<typename F::scalar_type, 2> &x0,
+    const std::array<typename F::scalar_type, 2> &direction,
+    const std::vector<typename F::scalar_type> &alphas) {
+  std::vector<typename F::scalar_type> phi(alphas.size());
+  for (size_t idx = 0; idx < alphas.size(); ++idx) {
+    phi[idx] = F::value_kernel(
+        x0[0] + alphas[idx] * direction[0], x0[1] + alphas[idx] * direction[1]);
+  }
+  return phi;
+}
+
+template <StaticGradient2D F>
+std::vector<typename F::scalar_type> static_line_slopes(
+    const std::array<typename F::scalar_type, 2> &x0,
+    const std::array<typename F::scalar_type, 2> &direction,
+    const std::vector<typename F::scalar_type> &alphas) {
+  std::vector<typename F::scalar_type> dphi(alphas.size());
+  for (size_t idx = 0; idx < alphas.size(); ++idx) {
+    auto [df_dx, df_dy] = F::gradient_kernel(
+        x0[0] + alphas[idx] * direction[0], x0[1] + alphas[idx] * direction[1]);
+    dphi[idx] = df_dx * direction[0] + df_dy * direction[1];
+  }
+  return dphi;
+}
+
+} // namespace func
+} // namespace xts
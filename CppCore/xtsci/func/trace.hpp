@@ -0,0 +1,322 @@
+#pragma once
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Wall time tracing of the evaluation hot paths. XTSCI_TRACE_SCOPE("name")
+// times the enclosing scope; it only expands to anything when built with
+// XTSCI_ENABLE_TRACING (meson -Dwith_tracing=true), otherwise instrumented
+// code is exactly as before. The recorder below is always available so it can
+// also time user code.
+#define XTSCI_TRACE_CONCAT_(lhs, rhs) lhs##rhs
+#define XTSCI_TRACE_CONCAT(lhs, rhs) XTSCI_TRACE_CONCAT_(lhs, rhs)
+#ifdef XTSCI_ENABLE_TRACING
+#define XTSCI_TRACE_SCOPE(name)                                                \
+  const ::xts::func::trace::ScopedTimer XTSCI_TRACE_CONCAT(                    \
+      xtsci_trace_scope_, __LINE__)(name)
+#else
+#define XTSCI_TRACE_SCOPE(name) static_cast<void>(0)
+#endif
+
+namespace xts {
+namespace func {
+namespace trace {
+
+struct TraceEvent {
+  const char *name; // Static string, e.g. a literal
+  uint64_t start_ns;
+  uint64_t duration_ns;
+  uint32_t thread;
+};
+
+// Durations of one scope, bucket b counts durations in [2^(b-1), 2^b) ns
+struct Histogram {
+  static constexpr size_t n_buckets = 64;
+
+  size_t count      = 0;
+  uint64_t total_ns = 0;
+  uint64_t min_ns   = std::numeric_limits<uint64_t>::max();
+  uint64_t max_ns   = 0;
+  std::array<size_t, n_buckets> buckets{};
+
+  void add(uint64_t duration_ns) {
+    ++count;
+    total_ns += duration_ns;
+    min_ns = std::min(min_ns, duration_ns);
+    max_ns = std::max(max_ns, duration_ns);
+    ++buckets[std::min<size_t>(std::bit_width(duration_ns), n_buckets - 1)];
+  }
+
+  double mean_ns() const {
+    return count == 0 ? 0.0 : static_cast<double>(total_ns) / count;
+  }
+
+  // Upper bound of the bucket holding quantile q, clamped to max_ns
+  uint64_t quantile_ns(double q) const {
+    const auto target = static_cast<size_t>(q * count);
+    size_t seen       = 0;
+    for (size_t bucket = 0; bucket < n_buckets; ++bucket) {
+      seen += buckets[bucket];
+      if (seen > target) {
+        return std::min(max_ns, (uint64_t{1} << bucket) - 1);
+      }
+    }
+    return max_ns;
+  }
+};
+
+// Events of a single thread. Only the owning thread appends, into fixed size
+// chunks whose fill level is published with a release store, so recording
+// never locks and readers may walk the chunks at any time.
+class ThreadBuffer {
+public:
+  explicit ThreadBuffer(uint32_t thread)
+      : m_thread(thread), m_head(std::make_unique<Chunk>()),
+        m_tail(m_head.get()) {}
+
+  ~ThreadBuffer() { this->drop_after_head(); }
+
+  ThreadBuffer(const ThreadBuffer &)            = delete;
+  ThreadBuffer &operator=(const ThreadBuffer &) = delete;
+
+  uint32_t thread() const { return m_thread; }
+
+  void record(const char *name, uint64_t start_ns, uint64_t duration_ns) {
+    size_t fill = m_tail->size.load(std::memory_order_relaxed);
+    if (fill == chunk_size) {
+      auto *chunk = new Chunk();
+      m_tail->next.store(chunk, std::memory_order_release);
+      m_tail = chunk;
+      fill   = 0;
+    }
+    m_tail->events[fill] = {name, start_ns, duration_ns, m_thread};
+    m_tail->size.store(fill + 1, std::memory_order_release);
+  }
+
+  template <class Fn> void for_each(Fn &&fn) const {
+    const Chunk *chunk = m_head.get();
+    while (chunk != nullptr) {
+      const size_t fill = chunk->size.load(std::memory_order_acquire);
+      for (size_t idx = 0; idx < fill; ++idx) {
+        fn(chunk->events[idx]);
+      }
+      chunk = chunk->next.load(std::memory_order_acquire);
+    }
+  }
+
+  // NOTE: Not safe while the owning thread records
+  void clear() {
+    this->drop_after_head();
+    m_head->size.store(0, std::memory_order_release);
+    m_tail = m_head.get();
+  }
+
+private:
+  static constexpr size_t chunk_size = 4096;
+  struct Chunk {
+    std::array<TraceEvent, chunk_size> events;
+    std::atomic<size_t> size{0};
+    std::atomic<Chunk *> next{nullptr};
+  };
+
+  uint32_t m_thread;
+  std::unique_ptr<Chunk> m_head;
+  Chunk *m_tail;
+
+  void drop_after_head() {
+    Chunk *chunk = m_head->next.exchange(nullptr);
+    while (chunk != nullptr) {
+      Chunk *next = chunk->next.load();
+      delete chunk;
+      chunk = next;
+    }
+  }
+};
+
+// Process wide recorder. Each thread takes a buffer on its first event, the
+// only locked step, and hands it back when it exits. Buffers outlive their
+// threads so events from finished workers are still exported, and a later
+// thread appends to a returned buffer (under the same thread id) instead of
+// allocating its own. Times are relative to the recorder's creation.
+class Tracer {
+public:
+  static Tracer &instance() {
+    static Tracer tracer;
+    return tracer;
+  }
+
+  // Runtime switch on top of the compile time one
+  void set_enabled(bool enabled) {
+    m_enabled.store(enabled, std::memory_order_relaxed);
+  }
+  bool enabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+  uint64_t now_ns() const {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - m_origin)
+            .count());
+  }
+
+  void record(const char *name, uint64_t start_ns, uint64_t duration_ns) {
+    thread_local const Lease lease(*this);
+    lease.buffer().record(name, start_ns, duration_ns);
+  }
+
+  std::vector<TraceEvent> events() const {
+    std::vector<TraceEvent> all;
+    std::scoped_lock lock(m_mutex);
+    for (const auto &buffer : m_buffers) {
+      buffer->for_each([&](const TraceEvent &event) { all.push_back(event); });
+    }
+    std::sort(all.begin(), all.end(), [](const auto &lhs, const auto &rhs) {
+      return lhs.start_ns < rhs.start_ns;
+    });
+    return all;
+  }
+
+  // Per scope name, over every thread
+  std::map<std::string, Histogram> histograms() const {
+    std::map<std::string, Histogram> hists;
+    for (const auto &event : this->events()) {
+      hists[event.name].add(event.duration_ns);
+    }
+    return hists;
+  }
+
+  // Chrome trace event format (complete events), loads in chrome://tracing
+  // and ui.perfetto.dev
+  std::string chrome_trace() const {
+    std::ostringstream out;
+    // Microseconds, to the nanosecond
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+    const auto all = this->events();
+    for (size_t idx = 0; idx < all.size(); ++idx) {
+      const TraceEvent &event = all[idx];
+      out << (idx == 0 ? "\n" : ",\n") << "{\"name\": \"";
+      json_escape(out, event.name);
+      out << "\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << event.thread
+          << ", \"ts\": " << event.start_ns / 1e3
+          << ", \"dur\": " << event.duration_ns / 1e3 << "}";
+    }
+    out << "\n]}\n";
+    return out.str();
+  }
+
+  void write_chrome_trace(const std::string &filename) const {
+    std::ofstream file(filename);
+    if (!file) {
+      throw std::runtime_error("Cannot open trace file " + filename);
+    }
+    file << this->chrome_trace();
+  }
+
+  // NOTE: Only while no thread is recording
+  void reset() {
+    std::scoped_lock lock(m_mutex);
+    for (auto &buffer : m_buffers) {
+      buffer->clear();
+    }
+  }
+
+private:
+  Tracer() : m_origin(std::chrono::steady_clock::now()) {}
+
+  // Writes text as the body of a JSON string
+  static void json_escape(std::ostream &out, const char *text) {
+    for (; *text != '\0'; ++text) {
+      const auto chr = static_cast<unsigned char>(*text);
+      if (chr == '"' || chr == '\\') {
+        out << '\\' << *text;
+      } else if (chr < 0x20) {
+        const char *hex = "0123456789abcdef";
+        out << "\\u00" << hex[chr >> 4] << hex[chr & 0xf];
+      } else {
+        out << *text;
+      }
+    }
+  }
+
+  std::chrono::steady_clock::time_point m_origin;
+  std::atomic<bool> m_enabled{true};
+  mutable std::mutex m_mutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+  std::vector<ThreadBuffer *> m_free; // Owned by m_buffers, no live thread
+
+  // Holds the buffer of one thread, returning it when the thread exits
+  class Lease {
+  public:
+    explicit Lease(Tracer &tracer)
+        : m_tracer(tracer), m_buffer(tracer.acquire_buffer()) {}
+    ~Lease() { m_tracer.release_buffer(m_buffer); }
+
+    Lease(const Lease &)            = delete;
+    Lease &operator=(const Lease &) = delete;
+
+    ThreadBuffer &buffer() const { return *m_buffer; }
+
+  private:
+    Tracer &m_tracer;
+    ThreadBuffer *m_buffer;
+  };
+
+  ThreadBuffer *acquire_buffer() {
+    std::scoped_lock lock(m_mutex);
+    if (!m_free.empty()) {
+      ThreadBuffer *buffer = m_free.back();
+      m_free.pop_back();
+      return buffer;
+    }
+    const auto thread = static_cast<uint32_t>(m_buffers.size());
+    m_buffers.push_back(std::make_unique<ThreadBuffer>(thread));
+    return m_buffers.back().get();
+  }
+
+  void release_buffer(ThreadBuffer *buffer) {
+    std::scoped_lock lock(m_mutex);
+    m_free.push_back(buffer);
+  }
+};
+
+// Records the lifetime of the enclosing scope under name
+class ScopedTimer {
+public:
+  explicit ScopedTimer(const char *name)
+      : m_name(Tracer::instance().enabled() ? name : nullptr),
+        m_start(m_name != nullptr ? Tracer::instance().now_ns() : 0) {}
+
+  ~ScopedTimer() {
+    if (m_name != nullptr) {
+      Tracer &tracer = Tracer::instance();
+      tracer.record(m_name, m_start, tracer.now_ns() - m_start);
+    }
+  }
+
+  ScopedTimer(const ScopedTimer &)            = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+  const char *m_name;
+  uint64_t m_start;
+};
+
+} // namespace trace
+} // namespace func
+} // namespace xts
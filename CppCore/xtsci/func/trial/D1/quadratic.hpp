@@ -27,14 +27,14 @@ private:
 
   std::optional<xt::xarray<ScalarType>>
   compute_gradient(const xt::xarray<ScalarType> &x) const override {
-    return 2.0 * x; // 2x
+    return ScalarType{2} * x; // 2x
   }
 
   std::optional<xt::xarray<ScalarType>>
   compute_hessian(const xt::xarray<ScalarType> &x) const override {
     // For a quadratic function, the Hessian is constant: 2I where I is the
     // identity matrix.
-    return 2.0 * xt::eye(x.size());
+    return ScalarType{2} * xt::eye<ScalarType>(x.size());
   }
 };
 
@@ -0,0 +1,110 @@
+#pragma once
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include <optional>
+#include <tuple>
+#include <utility>
+
+#include "xtensor/xarray.hpp"
+#include "xtensor/xtensor.hpp"
+
+#include "xtsci/func/autodiff.hpp"
+#include "xtsci/func/base.hpp"
+
+namespace xts {
+namespace func {
+namespace trial {
+namespace D2 {
+
+// Any D2 trial function with every derivative taken by forward mode AD
+// through its generic value_kernel, e.g. AutoDiff2D<Eggholder>. The hand
+// written derivative kernels are not used, so this doubles as a reference to
+// check them against. f, \nabla f and \nabla^2 f come from a single
+// HyperDual evaluation.
+template <template <typename> class Trial, typename ScalarType = double>
+class AutoDiff2D : public ObjectiveFunction<ScalarType> {
+  using Kernel    = Trial<ScalarType>;
+  using Dual      = autodiff::Dual<ScalarType, 2>;
+  using HyperDual = autodiff::HyperDual<ScalarType, 2>;
+
+public:
+  explicit AutoDiff2D(
+      const xt::xtensor<bool, 1> &isFixed = xt::zeros<bool>({2}))
+      : ObjectiveFunction<ScalarType>(2, isFixed) {
+    Kernel reference;
+    this->minima  = reference.minima;
+    this->saddles = reference.saddles;
+  }
+
+private:
+  static Dual dual(const xt::xarray<ScalarType> &x) {
+    return Kernel::value_kernel(
+        Dual::variable(x(0), 0), Dual::variable(x(1), 1));
+  }
+
+  static HyperDual jet(const xt::xarray<ScalarType> &x) {
+    return Kernel::value_kernel(
+        HyperDual::variable(x(0), 0), HyperDual::variable(x(1), 1));
+  }
+
+  static xt::xarray<ScalarType> hessian_of(const HyperDual &fval) {
+    return xt::xarray<ScalarType>{
+        {fval.hess[0][0], fval.hess[0][1]}, {fval.hess[1][0], fval.hess[1][1]}};
+  }
+
+  ScalarType compute(const xt::xarray<ScalarType> &x) const override {
+    return Kernel::value_kernel(x(0), x(1));
+  }
+
+  std::optional<xt::xarray<ScalarType>>
+  compute_gradient(const xt::xarray<ScalarType> &x) const override {
+    const Dual fval = dual(x);
+    return xt::xarray<ScalarType>{fval.grad[0], fval.grad[1]};
+  }
+
+  std::pair<ScalarType, std::optional<xt::xarray<ScalarType>>>
+  compute_value_and_gradient(const xt::xarray<ScalarType> &x) const override {
+    const Dual fval = dual(x);
+    return {fval.val, xt::xarray<ScalarType>{fval.grad[0], fval.grad[1]}};
+  }
+
+  std::optional<xt::xarray<ScalarType>>
+  compute_hessian(const xt::xarray<ScalarType> &x) const override {
+    return hessian_of(jet(x));
+  }
+
+  std::tuple<
+      ScalarType, std::optional<xt::xarray<ScalarType>>,
+      std::optional<xt::xarray<ScalarType>>>
+  compute_value_gradient_hessian(
+      const xt::xarray<ScalarType> &x) const override {
+    const HyperDual fval = jet(x);
+    return {
+        fval.val, xt::xarray<ScalarType>{fval.grad[0], fval.grad[1]},
+        hessian_of(fval)};
+  }
+
+  xt::xtensor<ScalarType, 1>
+  compute_batch(const xt::xtensor<ScalarType, 2> &pts) const override {
+    return helpers::batch_value2D<Kernel>(pts);
+  }
+
+  std::optional<xt::xtensor<ScalarType, 2>>
+  compute_gradient_batch(const xt::xtensor<ScalarType, 2> &pts) const override {
+    const size_t npts = pts.shape(0);
+    xt::xtensor<ScalarType, 2> result
+        = xt::empty<ScalarType>({npts, size_t{2}});
+    for (size_t idx = 0; idx < npts; ++idx) {
+      const Dual fval = Kernel::value_kernel(
+          Dual::variable(pts(idx, 0), 0), Dual::variable(pts(idx, 1), 1));
+      result(idx, 0) = fval.grad[0];
+      result(idx, 1) = fval.grad[1];
+    }
+    return result;
+  }
+};
+
+} // namespace D2
+} // namespace trial
+} // namespace func
+} // namespace xts
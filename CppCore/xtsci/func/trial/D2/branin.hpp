@@ -37,33 +37,67 @@ private:
   static constexpr ScalarType s = 10;
   static constexpr ScalarType t = 1 / (8 * std::numbers::pi_v<ScalarType>);
 
+public: // Kernels, shared by the single point and batched paths
+  // Generic over T so that SIMD batches can be passed in, the math functions
+  // are found through ADL for those
+  template <class T> static T value_kernel(const T &x1, const T &x2) {
+    using std::cos;
+    const T inner = x2 - b * x1 * x1 + c * x1 - r;
+    return a * inner * inner + s * (1 - t) * cos(x1) + s;
+  }
+
+  template <class T>
+  static std::array<T, 2> gradient_kernel(const T &x1, const T &x2) {
+    using std::sin;
+    const T inner = x2 - b * x1 * x1 + c * x1 - r;
+    T df_dx1      = 2 * a * inner * (-2 * b * x1 + c) - s * (1 - t) * sin(x1);
+    T df_dx2      = 2 * a * inner;
+    return {df_dx1, df_dx2};
+  }
+
+  // Row-major {d2f_dx12, d2f_dxdy, d2f_dydx, d2f_dy2}
+  static std::array<ScalarType, 4>
+  hessian_kernel(ScalarType x1, ScalarType x2) {
+    const ScalarType inner = x2 - b * x1 * x1 + c * x1 - r;
+    const ScalarType slope = c - 2 * b * x1;
+    ScalarType d2f_dx12    = 2 * a * (slope * slope - 2 * b * inner)
+                             - s * (1 - t) * std::cos(x1);
+    ScalarType d2f_dxdy    = 2 * a * slope;
+    ScalarType d2f_dy2     = 2 * a;
+    return {d2f_dx12, d2f_dxdy, d2f_dxdy, d2f_dy2};
+  }
+
+private:
   ScalarType compute(const xt::xarray<ScalarType> &x) const override {
-    ScalarType x1 = x(0);
-    ScalarType x2 = x(1);
-    return a * std::pow(x2 - b * x1 * x1 + c * x1 - r, 2)
-           + s * (1 - t) * std::cos(x1) + s;
+    return value_kernel(x(0), x(1));
   }
 
   std::optional<xt::xarray<ScalarType>>
   compute_gradient(const xt::xarray<ScalarType> &x) const override {
-    ScalarType x1 = x(0);
-    ScalarType x2 = x(1);
-    ScalarType df_dx1
-        = 2 * a * (x2 - b * x1 * x1 + c * x1 - r) * (-2 * b * x1 + c)
-          - s * (1 - t) * std::sin(x1);
-    ScalarType df_dx2 = 2 * a * (x2 - b * x1 * x1 + c * x1 - r);
+    auto [df_dx1, df_dx2] = gradient_kernel(x(0), x(1));
     return xt::xarray<ScalarType>{df_dx1, df_dx2};
   }
 
+  std::pair<ScalarType, std::optional<xt::xarray<ScalarType>>>
+  compute_value_and_gradient(const xt::xarray<ScalarType> &x) const override {
+    auto [df_dx, df_dy] = gradient_kernel(x(0), x(1));
+    return {value_kernel(x(0), x(1)), xt::xarray<ScalarType>{df_dx, df_dy}};
+  }
+
+  xt::xtensor<ScalarType, 1>
+  compute_batch(const xt::xtensor<ScalarType, 2> &pts) const override {
+    return helpers::batch_value2D<Branin>(pts);
+  }
+
+  std::optional<xt::xtensor<ScalarType, 2>>
+  compute_gradient_batch(const xt::xtensor<ScalarType, 2> &pts) const override {
+    return helpers::batch_gradient2D<Branin>(pts);
+  }
+
   std::optional<xt::xarray<ScalarType>>
   compute_hessian(const xt::xarray<ScalarType> &x) const override {
-    ScalarType x1       = x(0);
-    ScalarType d2f_dx12 = 2 * a * (-2 * b + 2 * b * c - 4 * b * b * x1)
-                          - s * (1 - t) * std::cos(x1);
-    ScalarType d2f_dxdy         = 2 * a * (-2 * b * x1 + c);
-    ScalarType d2f_dy2          = 2 * a;
-    xt::xarray<ScalarType> hess = {{d2f_dx12, d2f_dxdy}, {d2f_dxdy, d2f_dy2}};
-    return hess;
+    auto [d2f_dx2, d2f_dxdy, d2f_dydx, d2f_dy2] = hessian_kernel(x(0), x(1));
+    return xt::xarray<ScalarType>{{d2f_dx2, d2f_dxdy}, {d2f_dydx, d2f_dy2}};
   }
 };
 
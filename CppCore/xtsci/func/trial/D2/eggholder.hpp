@@ -2,6 +2,8 @@
 // MIT License
 // Copyright 2023--present Rohit Goswami <HaoZeke>
 #include <algorithm>
+#include <array>
+#include <cmath>
 #include <functional>
 #include <limits>
 #include <optional>
@@ -10,6 +12,7 @@
 
 #include "xtensor-blas/xlinalg.hpp"
 
+#include "xtsci/func/autodiff.hpp"
 #include "xtsci/func/base.hpp"
 
 namespace xts {
@@ -27,13 +30,81 @@ public:
     this->minima = {{512, 404.2319}};
   }
 
+public: // Kernels, shared by the single point and batched paths
+  // Generic over T so that SIMD batches can be passed in, the math functions
+  // are found through ADL for those
+  template <class T> static T value_kernel(const T &x_val, const T &y_val) {
+    using std::abs;
+    using std::sin;
+    using std::sqrt;
+    const T shifted = y_val + ScalarType{47};
+    return -shifted * sin(sqrt(abs(x_val / ScalarType{2} + shifted)))
+           - x_val * sin(sqrt(abs(x_val - shifted)));
+  }
+
+  // With r = sqrt|u|, dr/du = u / (2 r^3), which avoids a sign branch. The
+  // gradient is undefined on the creases u = 0 where NaN is returned.
+  template <class T>
+  static std::array<T, 2> gradient_kernel(const T &x_val, const T &y_val) {
+    using std::abs;
+    using std::cos;
+    using std::sin;
+    using std::sqrt;
+    const T shifted = y_val + ScalarType{47};
+    const T u_one   = x_val / ScalarType{2} + shifted;
+    const T u_two   = x_val - shifted;
+    const T r_one   = sqrt(abs(u_one));
+    const T r_two   = sqrt(abs(u_two));
+    const T c_one   = shifted * cos(r_one) * u_one
+                    / (ScalarType{2} * r_one * r_one * r_one);
+    const T c_two   = x_val * cos(r_two) * u_two
+                    / (ScalarType{2} * r_two * r_two * r_two);
+    T df_dx         = -c_one / ScalarType{2} - sin(r_two) - c_two;
+    T df_dy         = -sin(r_one) - c_one + c_two;
+    return {df_dx, df_dy};
+  }
+
+  // Row-major {d2f_dx2, d2f_dxdy, d2f_dydx, d2f_dy2} by forward mode AD
+  // through value_kernel
+  static std::array<ScalarType, 4>
+  hessian_kernel(ScalarType x_val, ScalarType y_val) {
+    auto jet = autodiff::jet2D(
+        [](const auto &xv, const auto &yv) { return value_kernel(xv, yv); },
+        x_val, y_val);
+    return {jet.hess[0][0], jet.hess[0][1], jet.hess[1][0], jet.hess[1][1]};
+  }
+
 private:
   ScalarType compute(const xt::xarray<ScalarType> &x) const override {
-    ScalarType x_val = x(0);
-    ScalarType y_val = x(1);
-    return -(y_val + 47)
-               * std::sin(std::sqrt(std::abs(x_val / 2 + (y_val + 47))))
-           - x_val * std::sin(std::sqrt(std::abs(x_val - (y_val + 47))));
+    return value_kernel(x(0), x(1));
+  }
+
+  std::optional<xt::xarray<ScalarType>>
+  compute_gradient(const xt::xarray<ScalarType> &x) const override {
+    auto [df_dx, df_dy] = gradient_kernel(x(0), x(1));
+    return xt::xarray<ScalarType>{df_dx, df_dy};
+  }
+
+  std::pair<ScalarType, std::optional<xt::xarray<ScalarType>>>
+  compute_value_and_gradient(const xt::xarray<ScalarType> &x) const override {
+    auto [df_dx, df_dy] = gradient_kernel(x(0), x(1));
+    return {value_kernel(x(0), x(1)), xt::xarray<ScalarType>{df_dx, df_dy}};
+  }
+
+  std::optional<xt::xarray<ScalarType>>
+  compute_hessian(const xt::xarray<ScalarType> &x) const override {
+    auto [d2f_dx2, d2f_dxdy, d2f_dydx, d2f_dy2] = hessian_kernel(x(0), x(1));
+    return xt::xarray<ScalarType>{{d2f_dx2, d2f_dxdy}, {d2f_dydx, d2f_dy2}};
+  }
+
+  xt::xtensor<ScalarType, 1>
+  compute_batch(const xt::xtensor<ScalarType, 2> &pts) const override {
+    return helpers::batch_value2D<Eggholder>(pts);
+  }
+
+  std::optional<xt::xtensor<ScalarType, 2>>
+  compute_gradient_batch(const xt::xtensor<ScalarType, 2> &pts) const override {
+    return helpers::batch_gradient2D<Eggholder>(pts);
   }
 };
 
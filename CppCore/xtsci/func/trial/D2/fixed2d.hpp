@@ -0,0 +1,71 @@
+#pragma once
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include <array>
+#include <optional>
+
+#include "xtsci/func/fixed.hpp"
+
+namespace xts {
+namespace func {
+namespace trial {
+namespace D2 {
+
+// Stack allocated view of any D2 trial function, built on its static kernels,
+// e.g. Fixed2D<Rosenbrock> or Fixed2D<MullerBrown, float>. Derivatives are
+// provided whenever the trial function has the matching kernel.
+template <template <typename> class Trial, typename ScalarType = double>
+class Fixed2D : public FixedObjectiveFunction<ScalarType, 2> {
+  using Base   = FixedObjectiveFunction<ScalarType, 2>;
+  using Kernel = Trial<ScalarType>;
+
+public:
+  using typename Base::gradient_type;
+  using typename Base::hessian_type;
+  using typename Base::point_type;
+
+  static constexpr bool has_gradient = requires(ScalarType val) {
+    Kernel::gradient_kernel(val, val);
+  };
+  static constexpr bool has_hessian = requires(ScalarType val) {
+    Kernel::hessian_kernel(val, val);
+  };
+
+  explicit Fixed2D(const std::array<bool, 2> &isFixed = {false, false})
+      : Base(isFixed) {
+    Kernel reference;
+    this->minima  = reference.minima;
+    this->saddles = reference.saddles;
+  }
+
+private:
+  ScalarType compute(const point_type &x) const override {
+    return Kernel::value_kernel(x(0), x(1));
+  }
+
+  std::optional<gradient_type>
+  compute_gradient(const point_type &x) const override {
+    if constexpr (has_gradient) {
+      auto [df_dx, df_dy] = Kernel::gradient_kernel(x(0), x(1));
+      return gradient_type{df_dx, df_dy};
+    } else {
+      return std::nullopt;
+    }
+  }
+
+  std::optional<hessian_type>
+  compute_hessian(const point_type &x) const override {
+    if constexpr (has_hessian) {
+      auto [d2f_dx2, d2f_dxdy, d2f_dydx, d2f_dy2]
+          = Kernel::hessian_kernel(x(0), x(1));
+      return hessian_type{{d2f_dx2, d2f_dxdy}, {d2f_dydx, d2f_dy2}};
+    } else {
+      return std::nullopt;
+    }
+  }
+};
+
+} // namespace D2
+} // namespace trial
+} // namespace func
+} // namespace xts
@@ -33,40 +33,65 @@ public:
            {3.584428, -1.848126}};
   }
 
+public: // Kernels, shared by the single point and batched paths
+  // Generic over T so that SIMD batches can be passed in, constants are kept
+  // as ScalarType
+  template <class T> static T value_kernel(const T &x_val, const T &y_val) {
+    const T first  = x_val * x_val + y_val - ScalarType{11};
+    const T second = x_val + y_val * y_val - ScalarType{7};
+    return first * first + second * second;
+  }
+
+  template <class T>
+  static std::array<T, 2> gradient_kernel(const T &x_val, const T &y_val) {
+    const T first  = x_val * x_val + y_val - ScalarType{11};
+    const T second = x_val + y_val * y_val - ScalarType{7};
+    T df_dx        = ScalarType{4} * x_val * first + ScalarType{2} * second;
+    T df_dy        = ScalarType{2} * first + ScalarType{4} * y_val * second;
+    return {df_dx, df_dy};
+  }
+
+  // Row-major {d2f_dx2, d2f_dxdy, d2f_dydx, d2f_dy2}
+  static std::array<ScalarType, 4>
+  hessian_kernel(ScalarType x_val, ScalarType y_val) {
+    ScalarType d2f_dx2  = 4 * (3 * x_val * x_val + y_val - 11) + 2;
+    ScalarType d2f_dxdy = 4 * x_val + 4 * y_val;
+    ScalarType d2f_dydx = 4 * x_val + 4 * y_val;
+    ScalarType d2f_dy2  = 4 * (x_val + 3 * y_val * y_val - 7) + 2;
+    return {d2f_dx2, d2f_dxdy, d2f_dydx, d2f_dy2};
+  }
+
 private:
   ScalarType compute(const xt::xarray<ScalarType> &x) const override {
-    ScalarType x_val = x(0);
-    ScalarType y_val = x(1);
-    return (x_val * x_val + y_val - 11) * (x_val * x_val + y_val - 11)
-           + (x_val + y_val * y_val - 7) * (x_val + y_val * y_val - 7);
+    return value_kernel(x(0), x(1));
   }
 
   std::optional<xt::xarray<ScalarType>>
   compute_gradient(const xt::xarray<ScalarType> &x) const override {
-    ScalarType x_val = x(0);
-    ScalarType y_val = x(1);
-
-    ScalarType df_dx = 4 * x_val * (x_val * x_val + y_val - 11)
-                       + 2 * (x_val + y_val * y_val - 7);
-    ScalarType df_dy = 2 * (x_val * x_val + y_val - 11)
-                       + 4 * y_val * (x_val + y_val * y_val - 7);
-
+    auto [df_dx, df_dy] = gradient_kernel(x(0), x(1));
     return xt::xarray<ScalarType>{df_dx, df_dy};
   }
 
-  std::optional<xt::xarray<ScalarType>>
-  compute_hessian(const xt::xarray<ScalarType> &x) const override {
-    ScalarType x_val = x(0);
-    ScalarType y_val = x(1);
+  std::pair<ScalarType, std::optional<xt::xarray<ScalarType>>>
+  compute_value_and_gradient(const xt::xarray<ScalarType> &x) const override {
+    auto [df_dx, df_dy] = gradient_kernel(x(0), x(1));
+    return {value_kernel(x(0), x(1)), xt::xarray<ScalarType>{df_dx, df_dy}};
+  }
 
-    ScalarType d2f_dx2  = 4 * (3 * x_val * x_val + y_val - 11) + 2;
-    ScalarType d2f_dxdy = 4 * x_val + 4 * y_val;
-    ScalarType d2f_dydx = 4 * x_val + 4 * y_val;
-    ScalarType d2f_dy2  = 4 * (x_val + 3 * y_val * y_val - 7) + 2;
+  xt::xtensor<ScalarType, 1>
+  compute_batch(const xt::xtensor<ScalarType, 2> &pts) const override {
+    return helpers::batch_value2D<Himmelblau>(pts);
+  }
 
-    xt::xarray<ScalarType> hess = {{d2f_dx2, d2f_dxdy}, {d2f_dydx, d2f_dy2}};
+  std::optional<xt::xtensor<ScalarType, 2>>
+  compute_gradient_batch(const xt::xtensor<ScalarType, 2> &pts) const override {
+    return helpers::batch_gradient2D<Himmelblau>(pts);
+  }
 
-    return hess;
+  std::optional<xt::xarray<ScalarType>>
+  compute_hessian(const xt::xarray<ScalarType> &x) const override {
+    auto [d2f_dx2, d2f_dxdy, d2f_dydx, d2f_dy2] = hessian_kernel(x(0), x(1));
+    return xt::xarray<ScalarType>{{d2f_dx2, d2f_dxdy}, {d2f_dydx, d2f_dy2}};
   }
 };
 
@@ -11,6 +11,7 @@
 
 #include "xtensor-blas/xlinalg.hpp"
 
+#include "xtsci/func/autodiff.hpp"
 #include "xtsci/func/base.hpp"
 
 namespace xts {
@@ -52,75 +53,92 @@ private:
   static constexpr std::array<ScalarType, 4> x0 = {1, 0, -0.5, -1};
   static constexpr std::array<ScalarType, 4> y0 = {0, 0.5, 1.5, 1};
 
-  ScalarType compute(const xt::xarray<ScalarType> &x) const override {
-    ScalarType x_val  = x(0);
-    ScalarType y_val  = x(1);
-    ScalarType result = 0.0;
-    ScalarType two    = 2;
+public: // Kernels, shared by the single point and batched paths
+  // Generic over T so that SIMD batches can be passed in, the exponential is
+  // found through ADL for those
+  template <class T> static T value_kernel(const T &x_val, const T &y_val) {
+    using std::exp;
+    T result(ScalarType{0});
 
     for (size_t i = 0; i < 4; ++i) {
-      result += A[i]
-                * std::exp(
-                    a[i] * std::pow(x_val - x0[i], two)
-                    + b[i] * (x_val - x0[i]) * (y_val - y0[i])
-                    + c[i] * std::pow(y_val - y0[i], two));
+      const T dx = x_val - x0[i];
+      const T dy = y_val - y0[i];
+      result += A[i] * exp(a[i] * dx * dx + b[i] * dx * dy + c[i] * dy * dy);
     }
 
     return result;
   }
 
-  std::optional<xt::xarray<ScalarType>>
-  compute_gradient(const xt::xarray<ScalarType> &x) const override {
-    ScalarType x_val = x(0);
-    ScalarType y_val = x(1);
-    ScalarType df_dx = 0.0;
-    ScalarType df_dy = 0.0;
-    ScalarType two   = 2;
+  template <class T>
+  static std::array<T, 2> gradient_kernel(const T &x_val, const T &y_val) {
+    auto [fval, df_dx, df_dy] = value_gradient_kernel(x_val, y_val);
+    return {df_dx, df_dy};
+  }
+
+  // Shares the exponentials between f and \nabla f
+  template <class T>
+  static std::array<T, 3>
+  value_gradient_kernel(const T &x_val, const T &y_val) {
+    using std::exp;
+    T fval(ScalarType{0});
+    T df_dx(ScalarType{0});
+    T df_dy(ScalarType{0});
 
     for (size_t i = 0; i < 4; ++i) {
-      ScalarType exponent = a[i] * std::pow(x_val - x0[i], two)
-                            + b[i] * (x_val - x0[i]) * (y_val - y0[i])
-                            + c[i] * std::pow(y_val - y0[i], two);
-      ScalarType exp_value = std::exp(exponent);
-      df_dx += A[i] * exp_value
-               * (two * a[i] * (x_val - x0[i]) + b[i] * (y_val - y0[i]));
-      df_dy += A[i] * exp_value
-               * (b[i] * (x_val - x0[i]) + two * c[i] * (y_val - y0[i]));
+      const T dx = x_val - x0[i];
+      const T dy = y_val - y0[i];
+      const T scaled_exp
+          = A[i] * exp(a[i] * dx * dx + b[i] * dx * dy + c[i] * dy * dy);
+      fval += scaled_exp;
+      df_dx += scaled_exp * (2 * a[i] * dx + b[i] * dy);
+      df_dy += scaled_exp * (b[i] * dx + 2 * c[i] * dy);
     }
 
+    return {fval, df_dx, df_dy};
+  }
+
+  // Row-major {d2f_dx2, d2f_dxdy, d2f_dydx, d2f_dy2}, exact second
+  // derivatives by forward mode AD through value_kernel
+  static std::array<ScalarType, 4>
+  hessian_kernel(ScalarType x_val, ScalarType y_val) {
+    auto jet = autodiff::jet2D(
+        [](const auto &xv, const auto &yv) { return value_kernel(xv, yv); },
+        x_val, y_val);
+    return {jet.hess[0][0], jet.hess[0][1], jet.hess[1][0], jet.hess[1][1]};
+  }
+
+private:
+  ScalarType compute(const xt::xarray<ScalarType> &x) const override {
+    return value_kernel(x(0), x(1));
+  }
+
+  std::optional<xt::xarray<ScalarType>>
+  compute_gradient(const xt::xarray<ScalarType> &x) const override {
+    auto [df_dx, df_dy] = gradient_kernel(x(0), x(1));
     return xt::xarray<ScalarType>{df_dx, df_dy};
   }
 
-  // TODO(rgoswami): Fix this
-  // std::optional<xt::xarray<ScalarType>>
-  // compute_hessian(const xt::xarray<ScalarType> &x) const override {
-  // ScalarType x_val = x(0);
-  // ScalarType y_val = x(1);
-  // ScalarType d2f_dx2 = 0.0;
-  // ScalarType d2f_dy2 = 0.0;
-  // ScalarType d2f_dxdy = 0.0;
-  // ScalarType two = 2;
-  // for (size_t i = 0; i < 4; ++i) {
-  //   ScalarType exponent = a[i] * std::pow(x_val - x0[i], two) +
-  //                         b[i] * (x_val - x0[i]) * (y_val - y0[i]) +
-  //                         c[i] * std::pow(y_val - y0[i], two);
-  //   ScalarType exp_value = std::exp(exponent);
-
-  //   d2f_dx2 += A[i] * exp_value *
-  //              ((two * a[i]) * (two * a[i]) + two * a[i] +
-  //               b[i] * b[i] * std::pow(y_val - y0[i], two));
-  //   d2f_dy2 += A[i] * exp_value *
-  //              ((two * c[i]) * (two * c[i]) + two * c[i] +
-  //               b[i] * b[i] * std::pow(x_val - x0[i], two));
-  //   d2f_dxdy += A[i] * exp_value *
-  //               (two * a[i] * b[i] * (x_val - x0[i]) +
-  //                two * c[i] * b[i] * (y_val - y0[i]) +
-  //                b[i] * b[i] * (x_val - x0[i]) * (y_val - y0[i]));
-  // }
-
-  // xt::xarray<ScalarType> hess = {{d2f_dx2, d2f_dxdy}, {d2f_dxdy, d2f_dy2}};
-  // return hess;
-  // }
+  std::pair<ScalarType, std::optional<xt::xarray<ScalarType>>>
+  compute_value_and_gradient(const xt::xarray<ScalarType> &x) const override {
+    auto [fval, df_dx, df_dy] = value_gradient_kernel(x(0), x(1));
+    return {fval, xt::xarray<ScalarType>{df_dx, df_dy}};
+  }
+
+  xt::xtensor<ScalarType, 1>
+  compute_batch(const xt::xtensor<ScalarType, 2> &pts) const override {
+    return helpers::batch_value2D<MullerBrown>(pts);
+  }
+
+  std::optional<xt::xtensor<ScalarType, 2>>
+  compute_gradient_batch(const xt::xtensor<ScalarType, 2> &pts) const override {
+    return helpers::batch_gradient2D<MullerBrown>(pts);
+  }
+
+  std::optional<xt::xarray<ScalarType>>
+  compute_hessian(const xt::xarray<ScalarType> &x) const override {
+    auto [d2f_dx2, d2f_dxdy, d2f_dydx, d2f_dy2] = hessian_kernel(x(0), x(1));
+    return xt::xarray<ScalarType>{{d2f_dx2, d2f_dxdy}, {d2f_dydx, d2f_dy2}};
+  }
 
   // References:
   // [KMLB] K. Müller and L. D. Brown, “Location of saddle points and minimum
@@ -29,39 +29,66 @@ public:
     this->minima = {{1.0, 1.0}};
   }
 
+public: // Kernels, shared by the single point and batched paths
+  // Generic over T so that SIMD batches can be passed in, constants are kept
+  // as ScalarType
+  template <class T> static T value_kernel(const T &x_val, const T &y_val) {
+    const T one_minus_x = ScalarType{1} - x_val;
+    const T valley      = y_val - x_val * x_val;
+    return one_minus_x * one_minus_x + ScalarType{100} * valley * valley;
+  }
+
+  template <class T>
+  static std::array<T, 2> gradient_kernel(const T &x_val, const T &y_val) {
+    const T one_minus_x = ScalarType{1} - x_val;
+    const T valley      = y_val - x_val * x_val;
+
+    T df_dx = ScalarType{-2} * one_minus_x - ScalarType{400} * x_val * valley;
+    T df_dy = ScalarType{200} * valley;
+    return {df_dx, df_dy};
+  }
+
+  // Row-major {d2f_dx2, d2f_dxdy, d2f_dydx, d2f_dy2}
+  static std::array<ScalarType, 4>
+  hessian_kernel(ScalarType x_val, ScalarType y_val) {
+    ScalarType d2f_dx2  = 2 - 400 * y_val + 1200 * x_val * x_val;
+    ScalarType d2f_dxdy = -400 * x_val;
+    ScalarType d2f_dydx = -400 * x_val;
+    ScalarType d2f_dy2  = 200;
+    return {d2f_dx2, d2f_dxdy, d2f_dydx, d2f_dy2};
+  }
+
 private:
   ScalarType compute(const xt::xarray<ScalarType> &x) const override {
-    ScalarType x_val = x(0);
-    ScalarType y_val = x(1);
-    return (1 - x_val) * (1 - x_val)
-           + 100 * (y_val - x_val * x_val) * (y_val - x_val * x_val);
+    return value_kernel(x(0), x(1));
   }
 
   std::optional<xt::xarray<ScalarType>>
   compute_gradient(const xt::xarray<ScalarType> &x) const override {
-    ScalarType x_val = x(0);
-    ScalarType y_val = x(1);
-
-    ScalarType df_dx = -2 * (1 - x_val) - 400 * x_val * (y_val - x_val * x_val);
-    ScalarType df_dy = 200 * (y_val - x_val * x_val);
-
+    auto [df_dx, df_dy] = gradient_kernel(x(0), x(1));
     return xt::xarray<ScalarType>{df_dx, df_dy};
   }
 
-  // Hessian computation
-  std::optional<xt::xarray<ScalarType>>
-  compute_hessian(const xt::xarray<ScalarType> &x) const override {
-    ScalarType x_val = x(0);
-    ScalarType y_val = x(1);
+  std::pair<ScalarType, std::optional<xt::xarray<ScalarType>>>
+  compute_value_and_gradient(const xt::xarray<ScalarType> &x) const override {
+    auto [df_dx, df_dy] = gradient_kernel(x(0), x(1));
+    return {value_kernel(x(0), x(1)), xt::xarray<ScalarType>{df_dx, df_dy}};
+  }
 
-    ScalarType d2f_dx2  = 2 - 400 * y_val + 1200 * x_val * x_val;
-    ScalarType d2f_dxdy = -400 * x_val;
-    ScalarType d2f_dydx = -400 * x_val;
-    ScalarType d2f_dy2  = 200;
+  xt::xtensor<ScalarType, 1>
+  compute_batch(const xt::xtensor<ScalarType, 2> &pts) const override {
+    return helpers::batch_value2D<Rosenbrock>(pts);
+  }
 
-    xt::xarray<ScalarType> hess = {{d2f_dx2, d2f_dxdy}, {d2f_dydx, d2f_dy2}};
+  std::optional<xt::xtensor<ScalarType, 2>>
+  compute_gradient_batch(const xt::xtensor<ScalarType, 2> &pts) const override {
+    return helpers::batch_gradient2D<Rosenbrock>(pts);
+  }
 
-    return hess;
+  std::optional<xt::xarray<ScalarType>>
+  compute_hessian(const xt::xarray<ScalarType> &x) const override {
+    auto [d2f_dx2, d2f_dxdy, d2f_dydx, d2f_dy2] = hessian_kernel(x(0), x(1));
+    return xt::xarray<ScalarType>{{d2f_dx2, d2f_dxdy}, {d2f_dydx, d2f_dy2}};
   }
 };
 
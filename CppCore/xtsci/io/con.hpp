@@ -0,0 +1,228 @@
+#pragma once
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <fstream>
+#include <ostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "xtensor/xadapt.hpp"
+
+namespace xts {
+namespace io {
+
+// One frame of an eOn .con file. Buffers keep their capacity when a frame is
+// read into them again, so a trajectory of equally sized frames allocates
+// only for the first one.
+struct ConFrame {
+  std::array<double, 3> box_lengths{};
+  std::array<double, 3> box_angles{};
+  // Per component, i.e. per block of atoms of one element
+  std::vector<std::string> symbols;
+  std::vector<size_t> counts;
+  std::vector<double> masses;
+  // Per atom, positions are (n_atoms, 3) row major
+  std::vector<double> positions;
+  std::vector<bool> is_fixed;
+  std::vector<size_t> atom_ids;
+
+  size_t n_atoms() const { return is_fixed.size(); }
+
+  auto positions_view() {
+    return xt::adapt(
+        positions.data(), positions.size(), xt::no_ownership(),
+        std::array<size_t, 2>{n_atoms(), 3});
+  }
+};
+
+// Reads multi-frame .con trajectories (frames concatenated back to back) one
+// frame at a time, through a large stream buffer, so the file is never held
+// in memory. Numbers are parsed with from_chars, without locales or copies.
+class ConReader {
+public:
+  static constexpr size_t buffer_size = size_t{1} << 20;
+
+  explicit ConReader(const std::string &con_fname)
+      : m_fname(con_fname), m_buffer(std::make_unique<char[]>(buffer_size)) {
+    m_file.rdbuf()->pubsetbuf(m_buffer.get(), buffer_size);
+    m_file.open(con_fname);
+    if (!m_file) {
+      throw std::runtime_error("Cannot open con file " + con_fname);
+    }
+  }
+
+  // Parses the next frame into frame, false once the file is exhausted
+  bool next(ConFrame &frame) {
+    // Blank lines between frames are tolerated
+    do {
+      if (!std::getline(m_file, m_line)) {
+        return false;
+      }
+      ++m_line_no;
+    } while (m_line.find_first_not_of(" \t\r") == std::string::npos);
+    this->next_line(); // Second header line
+
+    Fields box = this->next_fields();
+    for (auto &len : frame.box_lengths) {
+      len = box.number();
+    }
+    Fields angles = this->next_fields();
+    for (auto &angle : frame.box_angles) {
+      angle = angles.number();
+    }
+    this->next_line();
+    this->next_line();
+
+    const auto n_components = this->next_fields().count();
+    frame.symbols.resize(n_components);
+    frame.counts.resize(n_components);
+    frame.masses.resize(n_components);
+    Fields counts  = this->next_fields();
+    size_t n_atoms = 0;
+    for (auto &count : frame.counts) {
+      count = counts.count();
+      n_atoms += count;
+    }
+    Fields masses = this->next_fields();
+    for (auto &mass : frame.masses) {
+      mass = masses.number();
+    }
+
+    frame.positions.resize(n_atoms * 3);
+    frame.is_fixed.resize(n_atoms);
+    frame.atom_ids.resize(n_atoms);
+    size_t atom = 0;
+    for (size_t comp = 0; comp < n_components; ++comp) {
+      frame.symbols[comp] = this->next_fields().word();
+      this->next_line(); // Coordinates of Component comp + 1
+      for (size_t idx = 0; idx < frame.counts[comp]; ++idx, ++atom) {
+        Fields coords = this->next_fields();
+        for (size_t dim = 0; dim < 3; ++dim) {
+          frame.positions[atom * 3 + dim] = coords.number();
+        }
+        frame.is_fixed[atom] = coords.count() != 0;
+        frame.atom_ids[atom] = coords.count();
+      }
+    }
+    ++m_frames;
+    return true;
+  }
+
+  size_t frames_read() const { return m_frames; }
+
+private:
+  // Whitespace separated fields of one line
+  class Fields {
+  public:
+    Fields(std::string_view line, const ConReader &reader)
+        : m_rest(line), m_reader(reader) {}
+
+    std::string_view word() {
+      const size_t start = m_rest.find_first_not_of(" \t\r");
+      if (start == std::string_view::npos) {
+        m_reader.fail("missing field");
+      }
+      m_rest = m_rest.substr(start);
+      const size_t stop
+          = std::min(m_rest.find_first_of(" \t\r"), m_rest.size());
+      const std::string_view field = m_rest.substr(0, stop);
+      m_rest                       = m_rest.substr(stop);
+      return field;
+    }
+
+    double number() { return this->parse<double>(); }
+    size_t count() { return this->parse<size_t>(); }
+
+  private:
+    std::string_view m_rest;
+    const ConReader &m_reader;
+
+    template <typename T> T parse() {
+      const std::string_view field = this->word();
+      T value{};
+      const auto [end, err]
+          = std::from_chars(field.data(), field.data() + field.size(), value);
+      if (err != std::errc() || end != field.data() + field.size()) {
+        m_reader.fail("bad number '" + std::string(field) + "'");
+      }
+      return value;
+    }
+  };
+
+  std::string m_fname;
+  std::unique_ptr<char[]> m_buffer;
+  std::ifstream m_file;
+  std::string m_line;
+  size_t m_line_no = 0;
+  size_t m_frames  = 0;
+
+  void next_line() {
+    if (!std::getline(m_file, m_line)) {
+      this->fail("truncated frame");
+    }
+    ++m_line_no;
+  }
+
+  Fields next_fields() {
+    this->next_line();
+    return Fields(m_line, *this);
+  }
+
+  [[noreturn]] void fail(const std::string &what) const {
+    throw std::runtime_error(
+        m_fname + ":" + std::to_string(m_line_no) + ": " + what);
+  }
+};
+
+// Writes frame in the layout ConReader reads, appending to out gives a
+// multi-frame trajectory
+inline void write_con(std::ostream &out, const ConFrame &frame) {
+  auto row = [&](const std::array<double, 3> &vals) {
+    out << vals[0] << " " << vals[1] << " " << vals[2] << "\n";
+  };
+  out << "Generated by xtsci\n0.0000 TIME\n";
+  // Enough digits for every double to read back exactly
+  const auto precision = out.precision(17);
+  row(frame.box_lengths);
+  row(frame.box_angles);
+  out << "0 0\n0 0 0\n" << frame.symbols.size() << "\n";
+  for (size_t count : frame.counts) {
+    out << count << " ";
+  }
+  out << "\n";
+  for (double mass : frame.masses) {
+    out << mass << " ";
+  }
+  out << "\n";
+  size_t atom = 0;
+  for (size_t comp = 0; comp < frame.symbols.size(); ++comp) {
+    out << frame.symbols[comp] << "\nCoordinates of Component " << comp + 1
+        << "\n";
+    for (size_t idx = 0; idx < frame.counts[comp]; ++idx, ++atom) {
+      out << frame.positions[atom * 3] << " " << frame.positions[atom * 3 + 1]
+          << " " << frame.positions[atom * 3 + 2] << " "
+          << (frame.is_fixed[atom] ? 1 : 0) << " " << frame.atom_ids[atom]
+          << "\n";
+    }
+  }
+  out.precision(precision);
+}
+
+inline void write_con(const std::string &con_fname, const ConFrame &frame) {
+  std::ofstream out(con_fname);
+  if (!out) {
+    throw std::runtime_error("Cannot open con file " + con_fname);
+  }
+  write_con(out, frame);
+}
+
+} // namespace io
+} // namespace xts
@@ -0,0 +1,294 @@
+#pragma once
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <zlib.h>
+
+namespace xts {
+namespace io {
+
+// Streaming writers for .npy and (stored, uncompressed) .npz files. The shape
+// is fixed up front and the data is appended in arbitrary chunks, so nothing
+// beyond the current chunk needs to live in memory. Little endian hosts only,
+// which is what xtensor-io assumes as well.
+
+template <typename T> constexpr const char *npy_descr() {
+  if constexpr (std::is_same_v<T, double>) {
+    return "<f8";
+  } else if constexpr (std::is_same_v<T, float>) {
+    return "<f4";
+  } else if constexpr (std::is_same_v<T, bool>) {
+    return "|b1";
+  } else if constexpr (std::is_same_v<T, int32_t>) {
+    return "<i4";
+  } else if constexpr (std::is_same_v<T, int64_t>) {
+    return "<i8";
+  } else if constexpr (std::is_same_v<T, uint64_t>) {
+    return "<u8";
+  } else {
+    static_assert(!sizeof(T), "Unsupported npy dtype");
+  }
+}
+
+// Version 1.0 header, padded so that the data starts on a 64 byte boundary
+inline std::string
+npy_header(const std::string &descr, const std::vector<size_t> &shape) {
+  std::string dict = "{'descr': '" + descr
+                     + "', 'fortran_order': False, 'shape': (";
+  for (size_t idx = 0; idx < shape.size(); ++idx) {
+    dict += std::to_string(shape[idx]);
+    if (shape.size() == 1 || idx + 1 < shape.size()) {
+      dict += ",";
+    }
+    if (idx + 1 < shape.size()) {
+      dict += " ";
+    }
+  }
+  dict += "), }";
+  constexpr size_t preamble = 10; // magic, version and header length
+  const size_t total        = preamble + dict.size() + 1;
+  dict.append((64 - total % 64) % 64, ' ');
+  dict += '\n';
+  if (dict.size() > std::numeric_limits<uint16_t>::max()) {
+    throw std::runtime_error("npy header too long");
+  }
+  std::string header("\x93NUMPY\x01\x00", 8);
+  header += static_cast<char>(dict.size() & 0xff);
+  header += static_cast<char>((dict.size() >> 8) & 0xff);
+  return header + dict;
+}
+
+inline size_t n_elements(const std::vector<size_t> &shape) {
+  return std::accumulate(
+      shape.begin(), shape.end(), size_t{1}, std::multiplies<size_t>());
+}
+
+template <typename T> class NpyStreamWriter {
+public:
+  NpyStreamWriter(const std::string &filename, std::vector<size_t> shape)
+      : m_out(filename, std::ios::binary | std::ios::trunc),
+        m_expected(n_elements(shape)) {
+    if (!m_out) {
+      throw std::runtime_error("Could not open " + filename);
+    }
+    const auto header = npy_header(npy_descr<T>(), shape);
+    m_out.write(header.data(), static_cast<std::streamsize>(header.size()));
+  }
+  NpyStreamWriter(const NpyStreamWriter &)            = delete;
+  NpyStreamWriter &operator=(const NpyStreamWriter &) = delete;
+  ~NpyStreamWriter() {
+    if (m_out.is_open()) {
+      m_out.close();
+    }
+  }
+
+  void append(const T *data, size_t count) {
+    if (m_written + count > m_expected) {
+      throw std::runtime_error("Appending past the declared npy shape");
+    }
+    m_out.write(
+        reinterpret_cast<const char *>(data),
+        static_cast<std::streamsize>(count * sizeof(T)));
+    m_written += count;
+  }
+
+  // Throws if fewer elements than the shape promised were written
+  void close() {
+    if (m_written != m_expected) {
+      throw std::runtime_error("npy stream closed before it was filled");
+    }
+    m_out.close();
+    if (!m_out) {
+      throw std::runtime_error("Failed to write npy stream");
+    }
+  }
+
+private:
+  std::ofstream m_out;
+  size_t m_expected;
+  size_t m_written{0};
+};
+
+// Writes one array at a time into a zip archive with stored entries. Sizes
+// are known from the shape, the CRC is patched in once an array is complete.
+// Entries are limited to 4 GiB (no zip64), use NpyStreamWriter beyond that.
+class NpzStreamWriter {
+public:
+  explicit NpzStreamWriter(const std::string &filename)
+      : m_out(filename, std::ios::binary | std::ios::trunc) {
+    if (!m_out) {
+      throw std::runtime_error("Could not open " + filename);
+    }
+  }
+  NpzStreamWriter(const NpzStreamWriter &)            = delete;
+  NpzStreamWriter &operator=(const NpzStreamWriter &) = delete;
+  ~NpzStreamWriter() {
+    if (m_out.is_open()) {
+      try {
+        this->close();
+      } catch (...) {
+        // Never throw from a destructor, an unfinished archive is unreadable
+      }
+    }
+  }
+
+  template <typename T>
+  void begin_array(const std::string &name, const std::vector<size_t> &shape) {
+    if (m_active) {
+      throw std::runtime_error("Previous npz entry was not finished");
+    }
+    const auto header = npy_header(npy_descr<T>(), shape);
+    const uint64_t size
+        = header.size() + static_cast<uint64_t>(n_elements(shape)) * sizeof(T);
+    if (size > std::numeric_limits<uint32_t>::max()) {
+      throw std::runtime_error("npz entry " + name + " exceeds 4 GiB");
+    }
+    Entry entry;
+    entry.name   = name + ".npy";
+    entry.size   = static_cast<uint32_t>(size);
+    entry.offset = this->tell32();
+    m_remaining  = n_elements(shape) * sizeof(T);
+    m_crc        = crc32(0L, Z_NULL, 0);
+
+    this->put32(0x04034b50); // Local file header
+    this->put16(20);         // Version needed
+    this->put16(0);          // Flags
+    this->put16(0);          // Stored
+    this->put16(0);          // Time
+    this->put16(0x21);       // Date, 1980-01-01
+    this->put32(0);          // CRC, patched in end_array
+    this->put32(entry.size);
+    this->put32(entry.size);
+    this->put16(static_cast<uint16_t>(entry.name.size()));
+    this->put16(0);
+    m_out.write(
+        entry.name.data(), static_cast<std::streamsize>(entry.name.size()));
+    m_entries.push_back(entry);
+    m_active = true;
+    this->write_bytes(header.data(), header.size());
+  }
+
+  template <typename T> void append(const T *data, size_t count) {
+    if (!m_active || count * sizeof(T) > m_remaining) {
+      throw std::runtime_error("Appending past the declared npz entry shape");
+    }
+    this->write_bytes(reinterpret_cast<const char *>(data), count * sizeof(T));
+    m_remaining -= count * sizeof(T);
+  }
+
+  void end_array() {
+    if (!m_active || m_remaining != 0) {
+      throw std::runtime_error("npz entry closed before it was filled");
+    }
+    auto &entry    = m_entries.back();
+    entry.crc      = static_cast<uint32_t>(m_crc);
+    const auto end = m_out.tellp();
+    m_out.seekp(static_cast<std::streamoff>(entry.offset) + 14);
+    this->put32(entry.crc);
+    m_out.seekp(end);
+    m_active = false;
+  }
+
+  // Convenience for small arrays which are already in memory
+  template <typename T>
+  void write_array(
+      const std::string &name, const std::vector<size_t> &shape,
+      const T *data) {
+    this->begin_array<T>(name, shape);
+    this->append(data, n_elements(shape));
+    this->end_array();
+  }
+
+  void close() {
+    if (!m_out.is_open()) {
+      return;
+    }
+    if (m_active) {
+      throw std::runtime_error("npz closed with an unfinished entry");
+    }
+    const uint32_t cd_offset = this->tell32();
+    for (const auto &entry : m_entries) {
+      this->put32(0x02014b50); // Central directory header
+      this->put16(20);         // Version made by
+      this->put16(20);         // Version needed
+      this->put16(0);
+      this->put16(0);
+      this->put16(0);
+      this->put16(0x21);
+      this->put32(entry.crc);
+      this->put32(entry.size);
+      this->put32(entry.size);
+      this->put16(static_cast<uint16_t>(entry.name.size()));
+      this->put16(0); // Extra
+      this->put16(0); // Comment
+      this->put16(0); // Disk
+      this->put16(0); // Internal attributes
+      this->put32(0); // External attributes
+      this->put32(entry.offset);
+      m_out.write(
+          entry.name.data(), static_cast<std::streamsize>(entry.name.size()));
+    }
+    const uint32_t cd_size = this->tell32() - cd_offset;
+    this->put32(0x06054b50); // End of central directory
+    this->put16(0);
+    this->put16(0);
+    this->put16(static_cast<uint16_t>(m_entries.size()));
+    this->put16(static_cast<uint16_t>(m_entries.size()));
+    this->put32(cd_size);
+    this->put32(cd_offset);
+    this->put16(0);
+    m_out.close();
+    if (!m_out) {
+      throw std::runtime_error("Failed to write npz stream");
+    }
+  }
+
+private:
+  struct Entry {
+    std::string name;
+    uint32_t size{0};
+    uint32_t offset{0};
+    uint32_t crc{0};
+  };
+  std::ofstream m_out;
+  std::vector<Entry> m_entries;
+  bool m_active{false};
+  size_t m_remaining{0};
+  uLong m_crc{0};
+
+  void write_bytes(const char *data, size_t count) {
+    m_crc = crc32_z(m_crc, reinterpret_cast<const Bytef *>(data), count);
+    m_out.write(data, static_cast<std::streamsize>(count));
+  }
+
+  void put16(uint16_t val) {
+    const char bytes[2] = {
+        static_cast<char>(val & 0xff), static_cast<char>((val >> 8) & 0xff)};
+    m_out.write(bytes, 2);
+  }
+
+  void put32(uint32_t val) {
+    this->put16(static_cast<uint16_t>(val & 0xffff));
+    this->put16(static_cast<uint16_t>((val >> 16) & 0xffff));
+  }
+
+  uint32_t tell32() {
+    const auto pos = static_cast<uint64_t>(m_out.tellp());
+    if (pos > std::numeric_limits<uint32_t>::max()) {
+      throw std::runtime_error("npz archive exceeds 4 GiB");
+    }
+    return static_cast<uint32_t>(pos);
+  }
+};
+
+} // namespace io
+} // namespace xts
@@ -0,0 +1,333 @@
+#pragma once
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "xtensor/xadapt.hpp"
+#include "xtensor/xtensor.hpp"
+
+#include "xtsci/io/con.hpp"
+
+namespace xts {
+namespace io {
+
+// Binary snapshots of a structure, a drop in for re-parsing .con text at
+// startup. A fixed header is followed by the sections below, each padded to
+// 8 bytes, so that every array can be used in place from a mapping:
+//   positions  f64[n_atoms * 3]
+//   gradient   f64[n_gradient]     (optional, the last evaluated gradient)
+//   masses     f64[n_components]
+//   counts     u64[n_components]
+//   atom_ids   u64[n_atoms]
+//   atom_types i32[n_atoms]
+//   symbols    char[8][n_components]
+//   fixed      u8[n_atoms]
+// Little endian hosts only, as for the npy writers.
+
+struct SnapshotHeader {
+  static constexpr std::array<char, 8> expected_magic
+      = {'X', 'T', 'S', 'C', 'I', 'S', 'N', 'P'};
+  static constexpr uint32_t current_version = 1;
+  enum Flags : uint32_t { has_energy = 1, has_gradient = 2 };
+
+  std::array<char, 8> magic;
+  uint32_t version;
+  uint32_t flags;
+  uint64_t n_atoms;
+  uint64_t n_components;
+  uint64_t n_gradient;
+  double energy;
+  std::array<double, 3> box_lengths;
+  std::array<double, 3> box_angles;
+};
+
+namespace detail {
+
+constexpr size_t padded(size_t n_bytes) { return (n_bytes + 7) / 8 * 8; }
+
+// Byte offsets of the sections, in file order
+struct SnapshotLayout {
+  size_t positions, gradient, masses, counts, atom_ids, atom_types, symbols,
+      fixed, total;
+
+  explicit SnapshotLayout(const SnapshotHeader &head) {
+    const size_t n_atoms = head.n_atoms;
+    const size_t n_comp  = head.n_components;
+    positions            = padded(sizeof(SnapshotHeader));
+    gradient             = positions + n_atoms * 3 * sizeof(double);
+    masses               = gradient + head.n_gradient * sizeof(double);
+    counts               = masses + n_comp * sizeof(double);
+    atom_ids             = counts + n_comp * sizeof(uint64_t);
+    atom_types           = atom_ids + n_atoms * sizeof(uint64_t);
+    symbols              = atom_types + padded(n_atoms * sizeof(int32_t));
+    fixed                = symbols + n_comp * 8;
+    total                = fixed + padded(n_atoms);
+  }
+};
+
+} // namespace detail
+
+// Read only mapping of a whole file, unmapped on destruction
+class MappedFile {
+public:
+  explicit MappedFile(const std::string &fname) {
+#ifdef _WIN32
+    std::ifstream file(fname, std::ios::binary);
+    if (!file) {
+      throw std::runtime_error("Cannot open " + fname);
+    }
+    m_copy.assign(
+        std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    m_data = reinterpret_cast<const std::byte *>(m_copy.data());
+    m_size = m_copy.size();
+#else
+    const int fd = ::open(fname.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("Cannot open " + fname);
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0) {
+      ::close(fd);
+      throw std::runtime_error("Cannot stat " + fname);
+    }
+    m_size = static_cast<size_t>(info.st_size);
+    if (m_size > 0) {
+      void *addr = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr == MAP_FAILED) {
+        ::close(fd);
+        throw std::runtime_error("Cannot map " + fname);
+      }
+      m_data = static_cast<const std::byte *>(addr);
+    }
+    // The mapping stays valid without the descriptor
+    ::close(fd);
+#endif
+  }
+
+  ~MappedFile() { this->release(); }
+
+  MappedFile(const MappedFile &)            = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile(MappedFile &&other) noexcept { *this = std::move(other); }
+  MappedFile &operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+      this->release();
+      m_data = std::exchange(other.m_data, nullptr);
+      m_size = std::exchange(other.m_size, 0);
+#ifdef _WIN32
+      m_copy = std::move(other.m_copy);
+#endif
+    }
+    return *this;
+  }
+
+  const std::byte *data() const { return m_data; }
+  size_t size() const { return m_size; }
+
+private:
+  const std::byte *m_data = nullptr;
+  size_t m_size           = 0;
+#ifdef _WIN32
+  std::vector<char> m_copy;
+#endif
+
+  void release() {
+#ifndef _WIN32
+    if (m_data != nullptr) {
+      ::munmap(const_cast<std::byte *>(m_data), m_size);
+    }
+#endif
+    m_data = nullptr;
+    m_size = 0;
+  }
+};
+
+// A mapped snapshot, the accessors are views into the mapping and live as
+// long as the Snapshot does
+class Snapshot {
+public:
+  explicit Snapshot(const std::string &fname)
+      : m_file(fname), m_header(this->checked_header(fname)),
+        m_layout(m_header) {
+    if (m_file.size() < m_layout.total) {
+      throw std::runtime_error("Truncated snapshot " + fname);
+    }
+  }
+
+  const SnapshotHeader &header() const { return m_header; }
+  size_t n_atoms() const { return m_header.n_atoms; }
+
+  auto positions() const {
+    return xt::adapt(
+        this->section<double>(m_layout.positions), n_atoms() * 3,
+        xt::no_ownership(), std::array<size_t, 2>{n_atoms(), 3});
+  }
+
+  auto atom_types() const {
+    return xt::adapt(
+        this->section<int32_t>(m_layout.atom_types), n_atoms(),
+        xt::no_ownership(), std::array<size_t, 1>{n_atoms()});
+  }
+
+  auto fixed() const {
+    return xt::adapt(
+        this->section<uint8_t>(m_layout.fixed), n_atoms(), xt::no_ownership(),
+        std::array<size_t, 1>{n_atoms()});
+  }
+
+  // (1, 3) box lengths, the layout extract_condat and XTPot use
+  xt::xtensor<double, 2> box_matrix() const {
+    xt::xtensor<double, 2> box = xt::empty<double>({size_t{1}, size_t{3}});
+    std::copy(
+        m_header.box_lengths.begin(), m_header.box_lengths.end(), box.begin());
+    return box;
+  }
+
+  std::optional<double> energy() const {
+    if (!(m_header.flags & SnapshotHeader::has_energy)) {
+      return std::nullopt;
+    }
+    return m_header.energy;
+  }
+
+  std::optional<xt::xtensor<double, 1>> gradient() const {
+    if (!(m_header.flags & SnapshotHeader::has_gradient)) {
+      return std::nullopt;
+    }
+    return xt::xtensor<double, 1>(xt::adapt(
+        this->section<double>(m_layout.gradient), m_header.n_gradient,
+        xt::no_ownership(), std::array<size_t, 1>{m_header.n_gradient}));
+  }
+
+  // Everything needed to write the structure back out as .con
+  ConFrame to_frame() const {
+    ConFrame frame;
+    frame.box_lengths = m_header.box_lengths;
+    frame.box_angles  = m_header.box_angles;
+
+    const size_t n_comp = m_header.n_components;
+    const char *names   = this->section<char>(m_layout.symbols);
+    for (size_t comp = 0; comp < n_comp; ++comp) {
+      const char *name = names + comp * 8;
+      frame.symbols.emplace_back(name, std::find(name, name + 8, '\0'));
+    }
+    const auto *counts = this->section<uint64_t>(m_layout.counts);
+    const auto *masses = this->section<double>(m_layout.masses);
+    frame.counts.assign(counts, counts + n_comp);
+    frame.masses.assign(masses, masses + n_comp);
+    const auto *pos = this->section<double>(m_layout.positions);
+    const auto *ids = this->section<uint64_t>(m_layout.atom_ids);
+    const auto *fix = this->section<uint8_t>(m_layout.fixed);
+    frame.positions.assign(pos, pos + n_atoms() * 3);
+    frame.atom_ids.assign(ids, ids + n_atoms());
+    frame.is_fixed.assign(fix, fix + n_atoms());
+    return frame;
+  }
+
+private:
+  MappedFile m_file;
+  SnapshotHeader m_header;
+  detail::SnapshotLayout m_layout;
+
+  template <typename T> const T *section(size_t offset) const {
+    return reinterpret_cast<const T *>(m_file.data() + offset);
+  }
+
+  SnapshotHeader checked_header(const std::string &fname) const {
+    SnapshotHeader head{};
+    if (m_file.size() < sizeof(SnapshotHeader)) {
+      throw std::runtime_error("Not a snapshot " + fname);
+    }
+    std::memcpy(&head, m_file.data(), sizeof(SnapshotHeader));
+    if (head.magic != SnapshotHeader::expected_magic) {
+      throw std::runtime_error("Not a snapshot " + fname);
+    }
+    if (head.version != SnapshotHeader::current_version) {
+      throw std::runtime_error(
+          "Unsupported snapshot version " + std::to_string(head.version));
+    }
+    return head;
+  }
+};
+
+// Writes frame, with atomic numbers atom_types, and optionally the energy and
+// gradient last evaluated at it
+inline void write_snapshot(
+    const std::string &fname, const ConFrame &frame,
+    const std::vector<int32_t> &atom_types,
+    std::optional<double> energy = std::nullopt,
+    const std::optional<xt::xtensor<double, 1>> &gradient = std::nullopt) {
+  const size_t n_atoms = frame.n_atoms();
+  const size_t n_comp  = frame.symbols.size();
+  if (atom_types.size() != n_atoms || frame.positions.size() != n_atoms * 3) {
+    throw std::invalid_argument("Snapshot arrays do not match the atoms.");
+  }
+  SnapshotHeader head{};
+  head.magic        = SnapshotHeader::expected_magic;
+  head.version      = SnapshotHeader::current_version;
+  head.flags        = (energy ? SnapshotHeader::has_energy : 0)
+                      | (gradient ? SnapshotHeader::has_gradient : 0);
+  head.n_atoms      = n_atoms;
+  head.n_components = n_comp;
+  head.n_gradient   = gradient ? gradient->size() : 0;
+  head.energy       = energy.value_or(0);
+  head.box_lengths  = frame.box_lengths;
+  head.box_angles   = frame.box_angles;
+
+  std::ofstream out(fname, std::ios::binary);
+  if (!out) {
+    throw std::runtime_error("Cannot open " + fname);
+  }
+  auto write = [&](const void *data, size_t n_bytes) {
+    out.write(static_cast<const char *>(data), n_bytes);
+    static constexpr std::array<char, 8> zeros{};
+    out.write(zeros.data(), detail::padded(n_bytes) - n_bytes);
+  };
+  write(&head, sizeof(head));
+  write(frame.positions.data(), n_atoms * 3 * sizeof(double));
+  if (gradient) {
+    write(gradient->data(), gradient->size() * sizeof(double));
+  }
+  write(frame.masses.data(), n_comp * sizeof(double));
+  const std::vector<uint64_t> counts(frame.counts.begin(), frame.counts.end());
+  write(counts.data(), n_comp * sizeof(uint64_t));
+  const std::vector<uint64_t> ids(frame.atom_ids.begin(), frame.atom_ids.end());
+  write(ids.data(), n_atoms * sizeof(uint64_t));
+  write(atom_types.data(), n_atoms * sizeof(int32_t));
+  std::vector<char> names(n_comp * 8, '\0');
+  for (size_t comp = 0; comp < n_comp; ++comp) {
+    if (frame.symbols[comp].size() > 8) {
+      throw std::invalid_argument("Symbols are at most 8 characters.");
+    }
+    frame.symbols[comp].copy(names.data() + comp * 8, 8);
+  }
+  write(names.data(), names.size());
+  const std::vector<uint8_t> fixed(
+      frame.is_fixed.begin(), frame.is_fixed.end());
+  write(fixed.data(), n_atoms);
+  if (!out) {
+    throw std::runtime_error("Failed writing " + fname);
+  }
+}
+
+} // namespace io
+} // namespace xts
@@ -5,7 +5,9 @@
 #include <functional>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <stdexcept>
 #include <string>
 #include <tuple>
 #include <utility>
@@ -15,6 +17,8 @@
 #include "rgpot/types/adapters/xtensor.hpp"
 #include "xtensor/xtensor_forward.hpp"
 #include "xtsci/func/base.hpp"
+#include "xtsci/func/block_sparse.hpp"
+#include "xtsci/func/parallel.hpp"
 #include <xtensor/xadapt.hpp>
 #include <xtensor/xindex_view.hpp>
 
@@ -26,77 +30,301 @@
 namespace xts {
 namespace pot {
 
+// rgpot potentials work in double, so positions, forces and energies are
+// always evaluated (and summed) in double. ScalarType only sets the storage
+// of the free coordinates and of the results, e.g. XTPot<float> for large
+// batches. The base positions stay in double so fixed atoms are never rounded.
 template <typename ScalarType = double>
 class XTPot : public func::ObjectiveFunction<ScalarType> {
   friend class TestXTPot; // Make a test class a friend
 public:
+  // Makes an independent potential instance, one per batch worker
+  using PotentialFactory = std::function<std::shared_ptr<rgpot::Potential>()>;
+
   XTPot(
       std::shared_ptr<rgpot::Potential> pot,
-      const xt::xtensor<ScalarType, 2> &base_pos,
+      xt::xtensor<double, 2> base_pos,
       const xt::xtensor<int, 1> &atomTypes,
       const xt::xtensor<double, 2> &boxMatrix,
       const xt::xtensor<bool, 1> &fixedMask = {})
       : func::ObjectiveFunction<ScalarType>(
           atomTypes.size() * 3, expandFixedMask(fixedMask, atomTypes.size())),
-        m_pot(pot), m_basepos(base_pos),
+        m_basepos(std::move(base_pos)),
         m_atomTypes(rgpot::types::adapt::xtensor::convertToVector(atomTypes)),
-        m_box(rgpot::types::adapt::xtensor::convertToArray3x3(boxMatrix)) {}
+        m_box(rgpot::types::adapt::xtensor::convertToArray3x3(boxMatrix)),
+        m_lengths(box_lengths(boxMatrix)), m_free_idx(free_indices(m_free)),
+        m_main(std::make_shared<Evaluator>(this->make_evaluator(pot))) {}
 
   virtual ~XTPot() = default;
 
   xt::xtensor<ScalarType, 1> get_free(const xt::xarray<ScalarType> &pos) const {
-    return xt::filter(xt::flatten(pos), m_free);
+    xt::xtensor<ScalarType, 1> free_x = xt::empty<ScalarType>(
+        {m_free_idx.size()});
+    for (size_t idx = 0; idx < m_free_idx.size(); ++idx) {
+      free_x(idx) = pos.flat(m_free_idx[idx]);
+    }
+    return free_x;
+  }
+
+  size_t n_atoms() const { return m_atomTypes.size(); }
+  size_t n_free() const { return m_free_idx.size(); }
+  bool points_are_free() const override { return true; }
+
+  // get_free from a flat (n_atoms * 3) buffer into n_free() values, for
+  // filling preallocated batches
+  template <typename T>
+  void gather_free(const T *positions, ScalarType *free_x) const {
+    for (size_t idx = 0; idx < m_free_idx.size(); ++idx) {
+      free_x[idx] = static_cast<ScalarType>(positions[m_free_idx[idx]]);
+    }
+  }
+
+  // Batches (evaluate_batch, gradient_batch, value_and_gradient_batch) are
+  // spread over n_threads workers, each with its own potential from factory
+  // and its own buffers. Results come back in row order regardless.
+  void enable_parallel_batches(
+      const PotentialFactory &factory, size_t n_threads = 0) {
+    auto pool              = std::make_shared<WorkerPool>();
+    const size_t n_workers = func::parallel::resolve_threads(n_threads);
+    pool->workers.reserve(n_workers);
+    for (size_t idx = 0; idx < n_workers; ++idx) {
+      pool->workers.push_back(this->make_evaluator(factory()));
+    }
+    m_pool = std::move(pool);
+  }
+  // Back to serial batches on the shared potential
+  void disable_parallel_batches() { m_pool.reset(); }
+  bool parallel_batches() const { return m_pool != nullptr; }
+
+  // Block sparse Hessian over the free atoms, site i being the i-th free
+  // atom. Only free atoms within cutoff of each other (minimum image) are
+  // coupled, and the whole pattern takes 3 * n_colours gradient differences,
+  // see func::sparse_hessian. For many body potentials the cutoff should
+  // cover the range of the Hessian, up to twice that of the potential.
+  std::optional<func::BlockSparseHessian<ScalarType>> sparse_hessian(
+      const xt::xarray<ScalarType> &free_x, ScalarType cutoff) const {
+    const xt::xtensor<ScalarType, 2> positions = this->reconstruct_full(free_x);
+    std::vector<size_t> free_atoms;
+    for (size_t atom = 0; atom < m_atomTypes.size(); ++atom) {
+      if (m_free(atom * 3)) {
+        free_atoms.push_back(atom);
+      }
+    }
+    const xt::xtensor<ScalarType, 2> free_pos
+        = xt::view(positions, xt::keep(free_atoms), xt::all());
+    return func::sparse_hessian(
+        *this, free_x, func::neighbours_within(free_pos, cutoff, m_lengths));
   }
 
 protected: // Useful to test the damn thing
   xt::xtensor<ScalarType, 2>
   reconstruct_full(const xt::xarray<ScalarType> &free_x) const {
+    XTSCI_TRACE_SCOPE("XTPot::reconstruct_full");
+    this->check_free_size(free_x);
     std::array<std::size_t, 2> shape = {m_atomTypes.size(), 3};
     xt::xtensor<double, 2> allpos    = xt::reshape_view(m_basepos, shape);
-    // Flatten all structures for simpler indexing
-    auto flat_indices = xt::from_indices(xt::nonzero(m_free));
-    // Check the size of free_x to match the flat indices count
-    if (flat_indices.size() != free_x.size()) {
-      throw std::runtime_error(
-          "Size mismatch between free positions and unmasked indices.");
+    for (size_t idx = 0; idx < m_free_idx.size(); ++idx) {
+      allpos.flat(m_free_idx[idx]) = free_x.flat(idx);
     }
-    xt::index_view(xt::flatten(allpos), flat_indices) = xt::flatten(free_x);
     return allpos;
   }
 
 private:
-  std::shared_ptr<rgpot::Potential> m_pot;
+  // A potential with the full position and force buffers handed to it, the
+  // free entries of positions are overwritten by every evaluation
+  struct Evaluator {
+    std::shared_ptr<rgpot::Potential> pot;
+    std::vector<double> positions;
+    std::vector<double> forces;
+    std::mutex lock;
+
+    Evaluator(
+        std::shared_ptr<rgpot::Potential> potential,
+        std::vector<double> base)
+        : pot(std::move(potential)), positions(std::move(base)),
+          forces(positions.size()) {}
+    Evaluator(Evaluator &&other) noexcept
+        : pot(std::move(other.pot)), positions(std::move(other.positions)),
+          forces(std::move(other.forces)) {}
+  };
+  struct WorkerPool {
+    std::vector<Evaluator> workers;
+    std::mutex lock;
+  };
+
   std::vector<int> m_atomTypes;
   std::array<std::array<double, 3>, 3> m_box;
   const xt::xtensor<bool, 1> m_free{!this->m_isFixed};
   xt::xtensor<double, 2> m_basepos;
+  std::array<ScalarType, 3> m_lengths;
 
-  ScalarType compute(const xt::xarray<ScalarType> &free_x) const override {
-    xt::xtensor<double, 2> positions = this->reconstruct_full(free_x);
+  // Periodic lengths for the minimum image, .con frames carry them as a
+  // single row while full cells are taken to be orthorhombic
+  static std::array<ScalarType, 3>
+  box_lengths(const xt::xtensor<double, 2> &boxMatrix) {
+    std::array<ScalarType, 3> lengths{};
+    const size_t n_rows = boxMatrix.shape(0);
+    if (boxMatrix.shape(1) == 3 && (n_rows == 1 || n_rows == 3)) {
+      for (size_t ax = 0; ax < 3; ++ax) {
+        lengths[ax] = n_rows == 1 ? boxMatrix(0, ax) : boxMatrix(ax, ax);
+      }
+    }
+    return lengths;
+  }
 
-    auto [energy, forces] = (*m_pot)(
-        rgpot::types::adapt::xtensor::convertToAtomMatrix(positions),
-        m_atomTypes, m_box);
+  // Flat indices of the free coordinates, computed once
+  std::vector<size_t> m_free_idx;
+  // Copies share the potentials, so they share the buffers and locks too
+  std::shared_ptr<Evaluator> m_main;
+  std::shared_ptr<WorkerPool> m_pool;
 
-    return energy;
+  Evaluator make_evaluator(std::shared_ptr<rgpot::Potential> potential) const {
+    return Evaluator(
+        std::move(potential),
+        std::vector<double>(m_basepos.cbegin(), m_basepos.cend()));
+  }
+
+  static std::vector<size_t> free_indices(const xt::xtensor<bool, 1> &free) {
+    std::vector<size_t> indices;
+    for (size_t idx = 0; idx < free.size(); ++idx) {
+      if (free(idx)) {
+        indices.push_back(idx);
+      }
+    }
+    return indices;
+  }
+
+  void check_free_size(const xt::xarray<ScalarType> &free_x) const {
+    if (m_free_idx.size() != free_x.size()) {
+      throw std::runtime_error(
+          "Size mismatch between free positions and unmasked indices.");
+    }
+  }
+
+  // One potential call on the persistent buffers of eval: the n_free values
+  // at free_x are scattered into the positions in place, rgpot reads and
+  // writes the buffers directly, and the free gradient is gathered into
+  // free_grad when given. Fixed atoms are never rewritten, so nothing is
+  // allocated or copied beyond the free coordinates. The caller holds
+  // eval.lock.
+  ScalarType evaluate_with(
+      Evaluator &eval, const ScalarType *free_x, ScalarType *free_grad) const {
+    // The in place counterpart of reconstruct_full
+    for (size_t idx = 0; idx < m_free_idx.size(); ++idx) {
+      eval.positions[m_free_idx[idx]] = static_cast<double>(free_x[idx]);
+    }
+    const rgpot::ForceInput input{
+        m_atomTypes.size(), eval.positions.data(), m_atomTypes.data(),
+        m_box[0].data()};
+    rgpot::ForceOut output{eval.forces.data(), 0, 0};
+    {
+      XTSCI_TRACE_SCOPE("XTPot::potential");
+      eval.pot->forceImpl(input, &output);
+    }
+    if (free_grad != nullptr) {
+      for (size_t idx = 0; idx < m_free_idx.size(); ++idx) {
+        free_grad[idx] = static_cast<ScalarType>(-eval.forces[m_free_idx[idx]]);
+      }
+    }
+    return static_cast<ScalarType>(output.energy);
+  }
+
+  ScalarType evaluate_free(
+      const xt::xarray<ScalarType> &free_x,
+      xt::xarray<ScalarType> *free_grad) const {
+    this->check_free_size(free_x);
+    // NOTE: Whether rgpot potentials are reentrant is unknown, so calls on
+    // the shared potential are serialised
+    std::lock_guard<std::mutex> lock(m_main->lock);
+    return this->evaluate_with(
+        *m_main, free_x.data(),
+        free_grad != nullptr ? free_grad->data() : nullptr);
+  }
+
+  // Rows of free_pts into energies and free_grads (either may be null), row
+  // order is kept whichever worker evaluates a row
+  void evaluate_rows(
+      const xt::xtensor<ScalarType, 2> &free_pts, ScalarType *energies,
+      ScalarType *free_grads) const {
+    const size_t n_free = m_free_idx.size();
+    if (free_pts.shape(1) != n_free) {
+      throw std::runtime_error(
+          "Size mismatch between free positions and unmasked indices.");
+    }
+    auto run = [&](Evaluator &eval, size_t row) {
+      const ScalarType fval = this->evaluate_with(
+          eval, free_pts.data() + row * n_free,
+          free_grads != nullptr ? free_grads + row * n_free : nullptr);
+      if (energies != nullptr) {
+        energies[row] = fval;
+      }
+    };
+    const size_t n_rows = free_pts.shape(0);
+    if (!m_pool) {
+      std::lock_guard<std::mutex> lock(m_main->lock);
+      for (size_t row = 0; row < n_rows; ++row) {
+        run(*m_main, row);
+      }
+      return;
+    }
+    // Workers own their potentials, so only concurrent batches contend
+    std::lock_guard<std::mutex> lock(m_pool->lock);
+    func::parallel::parallel_for(
+        n_rows, m_pool->workers.size(), [&](size_t worker, size_t row) {
+          run(m_pool->workers[worker], row);
+        });
+  }
+
+  ScalarType compute(const xt::xarray<ScalarType> &free_x) const override {
+    return this->evaluate_free(free_x, nullptr);
   }
 
   std::optional<xt::xarray<ScalarType>>
   compute_gradient(const xt::xarray<ScalarType> &free_x) const override {
-    xt::xtensor<double, 2> positions = this->reconstruct_full(free_x);
+    xt::xarray<ScalarType> free_grad = xt::empty<ScalarType>(
+        {m_free_idx.size()});
+    this->evaluate_free(free_x, &free_grad);
+    return free_grad;
+  }
+
+  // Forces come with every energy, so cache them too
+  bool fused_value_gradient() const override { return true; }
+
+  std::pair<ScalarType, std::optional<xt::xarray<ScalarType>>>
+  compute_value_and_gradient(
+      const xt::xarray<ScalarType> &free_x) const override {
+    xt::xarray<ScalarType> free_grad = xt::empty<ScalarType>(
+        {m_free_idx.size()});
+    const ScalarType energy = this->evaluate_free(free_x, &free_grad);
+    return {energy, std::move(free_grad)};
+  }
 
-    auto [energy, forces] = (*m_pot)(
-        rgpot::types::adapt::xtensor::convertToAtomMatrix(positions),
-        m_atomTypes, m_box);
+  xt::xtensor<ScalarType, 1>
+  compute_batch(const xt::xtensor<ScalarType, 2> &free_pts) const override {
+    xt::xtensor<ScalarType, 1> energies = xt::empty<ScalarType>(
+        {free_pts.shape(0)});
+    this->evaluate_rows(free_pts, energies.data(), nullptr);
+    return energies;
+  }
 
-    std::array<size_t, 2> shape = {m_atomTypes.size(), 3};
-    auto forces_xtensor
-        = xt::adapt(forces.data(), shape, xt::layout_type::row_major);
+  std::optional<xt::xtensor<ScalarType, 2>> compute_gradient_batch(
+      const xt::xtensor<ScalarType, 2> &free_pts) const override {
+    xt::xtensor<ScalarType, 2> free_grads = xt::empty<ScalarType>(
+        {free_pts.shape(0), m_free_idx.size()});
+    this->evaluate_rows(free_pts, nullptr, free_grads.data());
+    return free_grads;
+  }
 
-    // Convert forces to gradient
-    auto gradient       = -1.0 * forces_xtensor;
-    auto flat_free_grad = get_free(xt::flatten(gradient));
-    return flat_free_grad;
+  std::pair<
+      xt::xtensor<ScalarType, 1>, std::optional<xt::xtensor<ScalarType, 2>>>
+  compute_value_and_gradient_batch(
+      const xt::xtensor<ScalarType, 2> &free_pts) const override {
+    xt::xtensor<ScalarType, 1> energies = xt::empty<ScalarType>(
+        {free_pts.shape(0)});
+    xt::xtensor<ScalarType, 2> free_grads = xt::empty<ScalarType>(
+        {free_pts.shape(0), m_free_idx.size()});
+    this->evaluate_rows(free_pts, energies.data(), free_grads.data());
+    return {std::move(energies), std::move(free_grads)};
   }
 
   xt::xtensor<bool, 1>
@@ -146,7 +374,7 @@ template <typename ScalarType = double>
 inline XTPot<ScalarType> mk_xtpot_con(
     const std::string &con_fname, std::shared_ptr<rgpot::Potential> pot) {
   auto [positions, atomTypes, boxMatrix, booltypes] = extract_condat(con_fname);
-  xts::pot::XTPot<double> objFunc(
+  xts::pot::XTPot<ScalarType> objFunc(
       std::move(pot), positions, atomTypes, boxMatrix, booltypes);
   return objFunc;
 }
@@ -0,0 +1,67 @@
+#pragma once
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "xtensor/xtensor.hpp"
+
+#include "xtsci/io/con.hpp"
+#include "xtsci/io/snapshot.hpp"
+#include "xtsci/pot/base.hpp"
+
+namespace xts {
+namespace pot {
+
+// Atomic numbers of every atom in frame
+inline std::vector<int32_t> frame_atom_types(const io::ConFrame &frame) {
+  std::vector<std::string> per_atom;
+  per_atom.reserve(frame.n_atoms());
+  for (size_t comp = 0; comp < frame.symbols.size(); ++comp) {
+    per_atom.insert(per_atom.end(), frame.counts[comp], frame.symbols[comp]);
+  }
+  const auto numbers = yodecon::symbols_to_atomic_numbers(per_atom);
+  return std::vector<int32_t>(numbers.begin(), numbers.end());
+}
+
+// Parses the first frame of con_fname once, later runs map snap_fname
+inline void con_to_snapshot(
+    const std::string &con_fname, const std::string &snap_fname) {
+  io::ConReader reader(con_fname);
+  io::ConFrame frame;
+  if (!reader.next(frame)) {
+    throw std::runtime_error("No frame in " + con_fname);
+  }
+  io::write_snapshot(snap_fname, frame, frame_atom_types(frame));
+}
+
+inline void snapshot_to_con(
+    const std::string &snap_fname, const std::string &con_fname) {
+  io::write_con(con_fname, io::Snapshot(snap_fname).to_frame());
+}
+
+// mk_xtpot_con without any text parsing, the arrays are read straight from
+// the mapping. The base positions are copied once, into XTPot, which needs
+// them to seed the buffers every evaluation writes into.
+template <typename ScalarType = double>
+inline XTPot<ScalarType> mk_xtpot_snapshot(
+    const io::Snapshot &snap, std::shared_ptr<rgpot::Potential> pot) {
+  const xt::xtensor<int, 1> atomTypes = snap.atom_types();
+  const xt::xtensor<bool, 1> isFixed  = snap.fixed();
+  return XTPot<ScalarType>(
+      std::move(pot), snap.positions(), atomTypes, snap.box_matrix(), isFixed);
+}
+
+template <typename ScalarType = double>
+inline XTPot<ScalarType> mk_xtpot_snapshot(
+    const std::string &snap_fname, std::shared_ptr<rgpot::Potential> pot) {
+  return mk_xtpot_snapshot<ScalarType>(
+      io::Snapshot(snap_fname), std::move(pot));
+}
+
+} // namespace pot
+} // namespace xts
@@ -0,0 +1,99 @@
+#pragma once
+// MIT License
+// Copyright 2023--present Rohit Goswami <HaoZeke>
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "xtensor/xtensor.hpp"
+#include "xtensor/xview.hpp"
+
+#include "xtsci/io/con.hpp"
+#include "xtsci/pot/base.hpp"
+
+namespace xts {
+namespace pot {
+
+// Energies and free gradients of frames [first_frame, first_frame + n)
+template <typename ScalarType> struct TrajectoryBatch {
+  size_t first_frame;
+  xt::xtensor<ScalarType, 1> energies;
+  std::optional<xt::xtensor<ScalarType, 2>> gradients;
+};
+
+// Re-scores every frame of a .con trajectory with pot, batch_size frames at a
+// time, handing each scored batch to on_batch. Frames are streamed through
+// io::ConReader into one of two preallocated batches; while pot evaluates one
+// (across its workers when parallel batches are enabled) the next is parsed
+// on another thread. Frames must have pot's atoms, in the same order.
+template <typename ScalarType>
+size_t score_trajectory(
+    const XTPot<ScalarType> &pot, const std::string &con_fname,
+    size_t batch_size,
+    const std::function<void(const TrajectoryBatch<ScalarType> &)> &on_batch) {
+  if (batch_size == 0) {
+    throw std::invalid_argument("Trajectory batches need at least one frame.");
+  }
+  io::ConReader reader(con_fname);
+  io::ConFrame frame;
+  const size_t n_free = pot.n_free();
+  std::array<xt::xtensor<ScalarType, 2>, 2> batches;
+  for (auto &batch : batches) {
+    batch = xt::empty<ScalarType>({batch_size, n_free});
+  }
+  // Fills batch with up to batch_size frames, returns how many
+  auto fill = [&](xt::xtensor<ScalarType, 2> &batch) {
+    size_t n_rows = 0;
+    while (n_rows < batch_size && reader.next(frame)) {
+      if (frame.n_atoms() != pot.n_atoms()) {
+        throw std::runtime_error(
+            "Frame " + std::to_string(reader.frames_read() - 1) + " has "
+            + std::to_string(frame.n_atoms()) + " atoms, the potential "
+            + std::to_string(pot.n_atoms()) + ".");
+      }
+      pot.gather_free(frame.positions.data(), batch.data() + n_rows * n_free);
+      ++n_rows;
+    }
+    return n_rows;
+  };
+
+  size_t current  = 0;
+  size_t n_frames = 0;
+  auto pending    = std::async(std::launch::async, fill, std::ref(batches[0]));
+  while (true) {
+    const size_t n_rows = pending.get();
+    if (n_rows == 0) {
+      break;
+    }
+    const bool last = n_rows < batch_size;
+    if (!last) {
+      pending = std::async(
+          std::launch::async, fill, std::ref(batches[1 - current]));
+    }
+    TrajectoryBatch<ScalarType> scored{n_frames, {}, std::nullopt};
+    if (last) {
+      const xt::xtensor<ScalarType, 2> tail
+          = xt::view(batches[current], xt::range(0, n_rows), xt::all());
+      std::tie(scored.energies, scored.gradients)
+          = pot.value_and_gradient_batch(tail);
+    } else {
+      std::tie(scored.energies, scored.gradients)
+          = pot.value_and_gradient_batch(batches[current]);
+    }
+    on_batch(scored);
+    n_frames += n_rows;
+    if (last) {
+      break;
+    }
+    current = 1 - current;
+  }
+  return n_frames;
+}
+
+} // namespace pot
+} // namespace xts
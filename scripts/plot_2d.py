@@ -31,6 +31,9 @@ grid = np.load(args.filename)
 X = grid.get("x")
 Y = grid.get("y")
 Z = grid.get("z")
+# Streamed grids may only store the 1-D axes
+if X.ndim == 1 and Y.ndim == 1:
+    X, Y = np.meshgrid(X, Y, indexing="ij")
 
 # Identify the minima with exclusion zones
 minima_coords = []